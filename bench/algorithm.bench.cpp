@@ -0,0 +1,158 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/algorithm.h>
+#include <fn2/function_vector.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t NUM_HANDLERS = 1 << 15;
+
+struct Event {
+    std::uint64_t value;
+};
+
+template <std::uint64_t N>
+struct Handler {
+    std::uint64_t state;
+
+    void operator()(Event &event) {
+        state += event.value * N;
+        event.value ^= state >> N;
+    }
+};
+
+template <std::size_t ...Is>
+fn2::Function<void(Event&)> make_handler(std::size_t type, std::index_sequence<Is...>) {
+    fn2::Function<void(Event&)> handler;
+    ((type == Is ? static_cast<void>(handler = Handler<Is + 1>{Is}) : static_cast<void>(0)), ...);
+
+    return handler;
+}
+
+template <std::size_t ...Is>
+void push_handler(fn2::FunctionVector<void(Event&)> &handlers, std::size_t type,
+                  std::index_sequence<Is...>) {
+    ((type == Is ? static_cast<void>(handlers.push_back(Handler<Is + 1>{Is})) : static_cast<void>(0)), ...);
+}
+
+// handlers of 16 types in a random order
+std::vector<fn2::Function<void(Event&)>> make_handlers() {
+    std::mt19937 gen;
+    std::uniform_int_distribution<std::size_t> dist(0, 15);
+
+    std::vector<fn2::Function<void(Event&)>> handlers;
+    handlers.reserve(NUM_HANDLERS);
+
+    for (std::size_t i = 0; i < NUM_HANDLERS; ++i) {
+        handlers.push_back(make_handler(dist(gen), std::make_index_sequence<16>()));
+    }
+
+    return handlers;
+}
+
+void naive_loop(benchmark::State &state) {
+    auto handlers = make_handlers();
+    Event event{1};
+
+    for (auto _ : state) {
+        for (auto &handler : handlers) {
+            handler(event);
+        }
+
+        benchmark::DoNotOptimize(event);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_HANDLERS));
+}
+
+// the naive loop over handlers grouped by sort_by_target
+void sorted_loop(benchmark::State &state) {
+    auto handlers = make_handlers();
+    fn2::sort_by_target(handlers.begin(), handlers.end());
+    Event event{1};
+
+    for (auto _ : state) {
+        for (auto &handler : handlers) {
+            handler(event);
+        }
+
+        benchmark::DoNotOptimize(event);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_HANDLERS));
+}
+
+// the same handlers as make_handlers, grouped by type
+void function_vector(benchmark::State &state) {
+    std::mt19937 gen;
+    std::uniform_int_distribution<std::size_t> dist(0, 15);
+
+    fn2::FunctionVector<void(Event&)> handlers;
+
+    for (std::size_t i = 0; i < NUM_HANDLERS; ++i) {
+        push_handler(handlers, dist(gen), std::make_index_sequence<16>());
+    }
+
+    Event event{1};
+
+    for (auto _ : state) {
+        handlers.invoke_all(event);
+        benchmark::DoNotOptimize(event);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_HANDLERS));
+}
+
+// filling one segment should take time linear in the number of handlers
+void function_vector_push_back(benchmark::State &state) {
+    const auto num_handlers = static_cast<std::size_t>(state.range(0));
+
+    for (auto _ : state) {
+        fn2::FunctionVector<void(Event&)> handlers;
+
+        for (std::size_t i = 0; i < num_handlers; ++i) {
+            handlers.push_back(Handler<1>{i});
+        }
+
+        benchmark::DoNotOptimize(handlers);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+    state.SetComplexityN(state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(naive_loop);
+BENCHMARK(sorted_loop);
+BENCHMARK(function_vector);
+BENCHMARK(function_vector_push_back)->RangeMultiplier(4)->Range(1 << 10, 1 << 18)->Complexity(benchmark::oN);
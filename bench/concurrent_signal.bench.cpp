@@ -0,0 +1,114 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/concurrent_signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t NUM_SLOTS = 64;
+
+struct Message {
+    std::uint64_t value;
+};
+
+// slots only read shared state, so that emission itself is measured
+struct Subscriber {
+    const std::uint64_t *scale;
+
+    void operator()(const Message &message) const noexcept {
+        benchmark::DoNotOptimize(message.value * *scale);
+    }
+};
+
+const std::uint64_t SCALE = 3;
+
+/** The baseline: a std::vector of Functions guarded by a std::mutex. */
+class MutexSignal {
+public:
+    template <typename F>
+    void connect(F &&f) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        slots_.emplace_back(std::forward<F>(f));
+    }
+
+    void emit(const Message &message) const {
+        const std::lock_guard<std::mutex> lock(mutex_);
+
+        for (const auto &slot : slots_) {
+            slot(message);
+        }
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<fn2::Function<void(const Message&) noexcept>> slots_;
+};
+
+template <typename S>
+S& make_signal() {
+    static S signal;
+    static std::once_flag connected;
+
+    std::call_once(connected, [] {
+        for (std::size_t i = 0; i < NUM_SLOTS; ++i) {
+            signal.connect(Subscriber{&SCALE});
+        }
+    });
+
+    return signal;
+}
+
+// every benchmark thread emits to the same signal
+template <typename S>
+void emit(benchmark::State &state) {
+    const S &signal = make_signal<S>();
+
+    for (auto _ : state) {
+        signal.emit(Message{1});
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_SLOTS));
+}
+
+void concurrent_signal_emit(benchmark::State &state) {
+    emit<fn2::ConcurrentSignal<void(const Message&) noexcept>>(state);
+}
+
+void mutex_signal_emit(benchmark::State &state) {
+    emit<MutexSignal>(state);
+}
+
+} // namespace
+
+BENCHMARK(concurrent_signal_emit)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(mutex_signal_emit)->ThreadRange(1, 32)->UseRealTime();
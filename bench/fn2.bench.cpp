@@ -0,0 +1,343 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/fn2.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t BATCH_SIZE = 1 << 10;
+
+/** A type-erased function wrapper built on virtual functions. */
+template <typename S>
+class Virtual;
+
+template <typename R, typename ...As>
+class Virtual<R(As...)> {
+public:
+    template <typename F>
+    Virtual(F f) : ptr_(std::make_unique<Impl<F>>(std::move(f))) { }
+
+    Virtual(const Virtual &other) : ptr_(other.ptr_->clone()) { }
+
+    Virtual(Virtual &&other) noexcept = default;
+
+    Virtual& operator=(const Virtual &other) {
+        ptr_ = other.ptr_->clone();
+
+        return *this;
+    }
+
+    Virtual& operator=(Virtual &&other) noexcept = default;
+
+    R operator()(As ...as) const {
+        return ptr_->call(std::forward<As>(as)...);
+    }
+
+    friend void swap(Virtual &lhs, Virtual &rhs) noexcept {
+        std::swap(lhs.ptr_, rhs.ptr_);
+    }
+
+private:
+    struct Base {
+        virtual ~Base() = default;
+
+        virtual R call(As ...as) = 0;
+
+        virtual std::unique_ptr<Base> clone() const = 0;
+    };
+
+    template <typename F>
+    struct Impl final : Base {
+        explicit Impl(F g) : f(std::move(g)) { }
+
+        R call(As ...as) override {
+            return std::invoke(f, std::forward<As>(as)...);
+        }
+
+        std::unique_ptr<Base> clone() const override {
+            return std::make_unique<Impl>(f);
+        }
+
+        F f;
+    };
+
+    std::unique_ptr<Base> ptr_;
+};
+
+template <typename S>
+using Fn2 = fn2::Function<S>;
+
+template <typename S>
+struct ConstSignature;
+
+template <typename R, typename ...As>
+struct ConstSignature<R(As...)> {
+    using Type = R(As...) const;
+};
+
+template <typename S>
+using Shared = fn2::SharedFunction<typename ConstSignature<S>::Type>;
+
+template <typename S>
+using LocalShared = fn2::LocalSharedFunction<typename ConstSignature<S>::Type>;
+
+template <typename S>
+using Std = std::function<S>;
+
+int add_one(int x) noexcept {
+    return x + 1;
+}
+
+struct FunctionPointer {
+    using Signature = int(int);
+
+    static auto make() noexcept {
+        return &add_one;
+    }
+
+    template <typename F>
+    static int call(const F &f, int x) {
+        return f(x);
+    }
+};
+
+struct EmptyLambda {
+    using Signature = int(int);
+
+    static auto make() noexcept {
+        return [](int x) { return x + 1; };
+    }
+
+    template <typename F>
+    static int call(const F &f, int x) {
+        return f(x);
+    }
+};
+
+/** A lambda expression that captures Size bytes. */
+template <std::size_t Size>
+struct Capture {
+    using Signature = int(int);
+
+    static auto make() noexcept {
+        std::array<int, Size / sizeof(int)> data = {};
+        data[0] = 1;
+
+        return [data](int x) { return x + data[0]; };
+    }
+
+    template <typename F>
+    static int call(const F &f, int x) {
+        return f(x);
+    }
+};
+
+struct Counter {
+    int get() const noexcept {
+        return value;
+    }
+
+    int value = 1;
+};
+
+struct MemberFunctionPointer {
+    using Signature = int(const Counter&);
+
+    static auto make() noexcept {
+        return &Counter::get;
+    }
+
+    template <typename F>
+    static int call(const F &f, int x) {
+        return f(Counter{x});
+    }
+};
+
+struct MemberDataPointer {
+    using Signature = int(const Counter&);
+
+    static auto make() noexcept {
+        return &Counter::value;
+    }
+
+    template <typename F>
+    static int call(const F &f, int x) {
+        return f(Counter{x});
+    }
+};
+
+template <template <typename> class W, typename C>
+using Wrapper = W<typename C::Signature>;
+
+template <template <typename> class W, typename C>
+void construct(benchmark::State &state) {
+    std::vector<std::optional<Wrapper<W, C>>> functions(BATCH_SIZE);
+
+    for (auto _ : state) {
+        for (auto &f : functions) {
+            f.emplace(C::make());
+        }
+
+        benchmark::ClobberMemory();
+
+        state.PauseTiming();
+
+        for (auto &f : functions) {
+            f.reset();
+        }
+
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * BATCH_SIZE));
+}
+
+template <template <typename> class W, typename C>
+void destroy(benchmark::State &state) {
+    std::vector<std::optional<Wrapper<W, C>>> functions(BATCH_SIZE);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+
+        for (auto &f : functions) {
+            f.emplace(C::make());
+        }
+
+        state.ResumeTiming();
+
+        for (auto &f : functions) {
+            f.reset();
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * BATCH_SIZE));
+}
+
+template <template <typename> class W, typename C>
+void copy(benchmark::State &state) {
+    const Wrapper<W, C> f = C::make();
+
+    for (auto _ : state) {
+        Wrapper<W, C> g = f;
+        benchmark::DoNotOptimize(g);
+    }
+}
+
+// replaces the wrapped object with a new one of the same type
+template <template <typename> class W, typename C>
+void assign(benchmark::State &state) {
+    Wrapper<W, C> f = C::make();
+
+    for (auto _ : state) {
+        f = C::make();
+        benchmark::DoNotOptimize(f);
+    }
+}
+
+template <template <typename> class W, typename C>
+void move(benchmark::State &state) {
+    Wrapper<W, C> f = C::make();
+
+    for (auto _ : state) {
+        Wrapper<W, C> g = std::move(f);
+        benchmark::DoNotOptimize(g);
+        f = std::move(g);
+        benchmark::DoNotOptimize(f);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+}
+
+template <template <typename> class W, typename C>
+void swap(benchmark::State &state) {
+    Wrapper<W, C> f = C::make();
+    Wrapper<W, C> g = C::make();
+
+    for (auto _ : state) {
+        using std::swap;
+
+        swap(f, g);
+        benchmark::DoNotOptimize(f);
+        benchmark::DoNotOptimize(g);
+    }
+}
+
+template <template <typename> class W, typename C>
+void invoke(benchmark::State &state) {
+    const Wrapper<W, C> f = C::make();
+    int x = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f);
+        x = C::call(f, x);
+        benchmark::DoNotOptimize(x);
+    }
+}
+
+} // namespace
+
+#define REGISTER_WRAPPER(W, C) \
+    BENCHMARK_TEMPLATE(construct, W, C); \
+    BENCHMARK_TEMPLATE(destroy, W, C); \
+    BENCHMARK_TEMPLATE(copy, W, C); \
+    BENCHMARK_TEMPLATE(assign, W, C); \
+    BENCHMARK_TEMPLATE(move, W, C); \
+    BENCHMARK_TEMPLATE(swap, W, C); \
+    BENCHMARK_TEMPLATE(invoke, W, C)
+
+#define REGISTER_CASE(C) \
+    REGISTER_WRAPPER(Fn2, C); \
+    REGISTER_WRAPPER(Std, C); \
+    REGISTER_WRAPPER(Virtual, C)
+
+using Capture16 = Capture<16>;
+using Capture48 = Capture<48>;
+using Capture64 = Capture<64>;
+using Capture128 = Capture<128>;
+using Capture256 = Capture<256>;
+
+REGISTER_CASE(FunctionPointer);
+REGISTER_CASE(EmptyLambda);
+REGISTER_CASE(Capture16);
+REGISTER_CASE(Capture48);
+REGISTER_CASE(Capture64);
+REGISTER_CASE(Capture128);
+REGISTER_CASE(Capture256);
+REGISTER_WRAPPER(Shared, Capture128);
+REGISTER_WRAPPER(Shared, Capture256);
+REGISTER_WRAPPER(LocalShared, Capture256);
+REGISTER_CASE(MemberFunctionPointer);
+REGISTER_CASE(MemberDataPointer);
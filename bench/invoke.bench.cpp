@@ -0,0 +1,167 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/fn2.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t NUM_FUNCTIONS = 1 << 12;
+
+enum class Mix {
+    Inline,
+    Heap,
+    Mixed,
+};
+
+fn2::Function<int(int)> make_inline(int offset) {
+    return [offset](int x) { return x + offset; };
+}
+
+fn2::Function<int(int)> make_heap(int offset) {
+    std::array<int, 32> offsets = {};
+    offsets[0] = offset;
+
+    return [offsets](int x) { return x + offsets[0]; };
+}
+
+std::vector<fn2::Function<int(int)>> make_functions(Mix mix) {
+    std::mt19937 gen;
+    std::bernoulli_distribution coin;
+
+    std::vector<fn2::Function<int(int)>> functions;
+    functions.reserve(NUM_FUNCTIONS);
+
+    for (std::size_t i = 0; i < NUM_FUNCTIONS; ++i) {
+        const auto offset = static_cast<int>(i);
+        const bool is_heap = (mix == Mix::Heap) || (mix == Mix::Mixed && coin(gen));
+
+        functions.push_back(is_heap ? make_heap(offset) : make_inline(offset));
+    }
+
+    return functions;
+}
+
+void invoke(benchmark::State &state, Mix mix) {
+    const auto functions = make_functions(mix);
+
+    for (auto _ : state) {
+        int sum = 0;
+
+        for (const auto &f : functions) {
+            sum += f(sum);
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_FUNCTIONS));
+}
+
+constexpr std::size_t NUM_COLD_FUNCTIONS = 1 << 20;
+
+template <typename S>
+using CachedFunction = fn2::BasicFunction<
+    S, fn2::detail::DEFAULT_CAPACITY - sizeof(void*), fn2::detail::DEFAULT_ALIGN,
+    fn2::Flags::CacheInvoke
+>;
+
+template <int N>
+auto make_affine(int offset) {
+    return [offset](int x) { return x * N + offset; };
+}
+
+// invokes each of many Functions, which are too many to fit in the
+// cache, once per iteration in a random order
+template <typename F>
+void invoke_cold(benchmark::State &state) {
+    std::vector<F> functions;
+    functions.reserve(NUM_COLD_FUNCTIONS);
+
+    for (std::size_t i = 0; i < NUM_COLD_FUNCTIONS; ++i) {
+        const auto offset = static_cast<int>(i);
+
+        switch (i % 4) {
+        case 0: functions.emplace_back(make_affine<1>(offset)); break;
+        case 1: functions.emplace_back(make_affine<2>(offset)); break;
+        case 2: functions.emplace_back(make_affine<3>(offset)); break;
+        default: functions.emplace_back(make_affine<4>(offset)); break;
+        }
+    }
+
+    std::vector<std::uint32_t> order(NUM_COLD_FUNCTIONS);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937());
+
+    for (auto _ : state) {
+        int sum = 0;
+
+        for (const std::uint32_t i : order) {
+            sum += functions[i](sum);
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_COLD_FUNCTIONS));
+}
+
+struct Pod {
+    std::array<std::uint64_t, 8> values;
+};
+
+template <typename T>
+void invoke_by_value(benchmark::State &state, T arg) {
+    const fn2::Function<std::size_t(T)> f = [](T t) {
+        benchmark::DoNotOptimize(t);
+
+        return sizeof(t);
+    };
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f(arg));
+    }
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(invoke, inline, Mix::Inline);
+BENCHMARK_CAPTURE(invoke, heap, Mix::Heap);
+BENCHMARK_CAPTURE(invoke, mixed, Mix::Mixed);
+
+BENCHMARK_TEMPLATE(invoke_cold, fn2::Function<int(int)>);
+BENCHMARK_TEMPLATE(invoke_cold, CachedFunction<int(int)>);
+
+BENCHMARK_CAPTURE(invoke_by_value, string, std::string(64, 'a'));
+BENCHMARK_CAPTURE(invoke_by_value, vector, std::vector<int>(16));
+BENCHMARK_CAPTURE(invoke_by_value, pod, Pod{});
@@ -0,0 +1,150 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/signal.h>
+
+#include <fn2/thread_pool.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+struct Message {
+    std::uint64_t value;
+};
+
+// every slot accumulates into its own counter
+struct Subscriber {
+    std::uint64_t *total;
+
+    void operator()(const Message &message) const noexcept {
+        *total += message.value;
+    }
+};
+
+// the baseline: subscribers stored in a std::vector of Functions
+void function_vector_emit(benchmark::State &state) {
+    const auto num_slots = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint64_t> totals(num_slots);
+    std::vector<fn2::Function<void(const Message&)>> slots;
+
+    for (std::uint64_t &total : totals) {
+        slots.emplace_back(Subscriber{&total});
+    }
+
+    for (auto _ : state) {
+        const Message message{1};
+
+        for (const auto &slot : slots) {
+            slot(message);
+        }
+
+        benchmark::DoNotOptimize(totals.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * num_slots));
+}
+
+void signal_emit(benchmark::State &state) {
+    const auto num_slots = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint64_t> totals(num_slots);
+    fn2::Signal<void(const Message&)> signal;
+
+    for (std::uint64_t &total : totals) {
+        signal.connect(Subscriber{&total});
+    }
+
+    for (auto _ : state) {
+        signal.emit(Message{1});
+
+        benchmark::DoNotOptimize(totals.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * num_slots));
+}
+
+// slots that each do enough work for a parallel emission to pay off
+void signal_emit_parallel(benchmark::State &state) {
+    constexpr std::size_t NUM_SLOTS = 1 << 14;
+    constexpr std::size_t GRAIN = 1 << 10;
+
+    fn2::ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint64_t> totals(NUM_SLOTS);
+    fn2::Signal<void(const Message&) noexcept> signal;
+
+    for (std::uint64_t &total : totals) {
+        signal.connect([&total](const Message &message) noexcept {
+            for (std::uint64_t i = 0; i < 64; ++i) {
+                total = total * 31 + message.value + i;
+            }
+        });
+    }
+
+    for (auto _ : state) {
+        signal.emit_parallel(pool, GRAIN, Message{1});
+
+        benchmark::DoNotOptimize(totals.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_SLOTS));
+}
+
+// connects then disconnects a slot among num_slots others
+void signal_connect_disconnect(benchmark::State &state) {
+    const auto num_slots = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint64_t> totals(num_slots + 1);
+    fn2::Signal<void(const Message&)> signal;
+
+    for (std::size_t i = 0; i < num_slots; ++i) {
+        signal.connect(Subscriber{&totals[i]});
+    }
+
+    for (auto _ : state) {
+        const auto connection = signal.connect(Subscriber{&totals[num_slots]});
+        benchmark::DoNotOptimize(signal.disconnect(connection));
+    }
+}
+
+void thread_counts(benchmark::internal::Benchmark *b) {
+    const unsigned max = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned n = 1; n <= max; n *= 2) {
+        b->Arg(n);
+    }
+}
+
+} // namespace
+
+BENCHMARK(function_vector_emit)->RangeMultiplier(8)->Range(8, 1 << 12);
+BENCHMARK(signal_emit)->RangeMultiplier(8)->Range(8, 1 << 12);
+BENCHMARK(signal_emit_parallel)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(signal_connect_disconnect)->RangeMultiplier(8)->Range(8, 1 << 12);
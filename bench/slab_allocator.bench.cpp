@@ -0,0 +1,135 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/fn2.h>
+#include <fn2/task_queue.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t NUM_LIVE = 256;
+constexpr std::size_t NUM_TASKS = 1 << 16;
+
+/** A lambda expression that captures Size bytes. */
+template <std::size_t Size>
+auto make_capture(int x) noexcept {
+    std::array<int, Size / sizeof(int)> data = {};
+    data[0] = x;
+
+    return [data] { return data[0]; };
+}
+
+/** Allocates wrapped objects with the default SlabAllocator. */
+struct Slab {
+    template <typename S, typename F>
+    static fn2::UniqueFunction<S> make(F &&f) {
+        return std::forward<F>(f);
+    }
+};
+
+/** Allocates wrapped objects with std::allocator, and so malloc. */
+struct Malloc {
+    template <typename S, typename F>
+    static fn2::UniqueFunction<S> make(F &&f) {
+        return {std::allocator_arg, std::allocator<std::byte>(), std::forward<F>(f)};
+    }
+};
+
+// each thread keeps NUM_LIVE Functions alive and replaces them in turn,
+// so every item is one deallocation and one allocation
+template <typename A, std::size_t Size>
+void churn(benchmark::State &state) {
+    std::vector<fn2::UniqueFunction<int()>> functions(NUM_LIVE);
+    std::size_t i = 0;
+    int sum = 0;
+
+    for (auto _ : state) {
+        auto &f = functions[i++ % NUM_LIVE];
+
+        if (f) {
+            sum += f();
+        }
+
+        f = A::template make<int()>(make_capture<Size>(1));
+    }
+
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// NUM_TASKS tasks are allocated by the benchmark thread and freed by
+// the thread that invokes them
+template <typename A, std::size_t Size>
+void handoff(benchmark::State &state) {
+    for (auto _ : state) {
+        fn2::TaskQueue queue(1024);
+
+        std::thread consumer([&queue] {
+            for (std::size_t invoked = 0; invoked < NUM_TASKS;) {
+                const std::size_t count = queue.invoke_all();
+
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+
+                invoked += count;
+            }
+        });
+
+        for (std::size_t i = 0; i < NUM_TASKS; ++i) {
+            fn2::TaskQueue::Task task = A::template make<void()>(
+                [f = make_capture<Size>(1)] { static_cast<void>(f()); }
+            );
+
+            while (!queue.try_push(std::move(task))) {
+                std::this_thread::yield();
+            }
+        }
+
+        consumer.join();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_TASKS));
+}
+
+} // namespace
+
+#define REGISTER_SIZE(Size) \
+    BENCHMARK_TEMPLATE(churn, Slab, Size)->ThreadRange(1, 8)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(churn, Malloc, Size)->ThreadRange(1, 8)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(handoff, Slab, Size)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(handoff, Malloc, Size)->UseRealTime()
+
+REGISTER_SIZE(64);
+REGISTER_SIZE(128);
+REGISTER_SIZE(256);
+REGISTER_SIZE(512);
@@ -0,0 +1,135 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/task_queue.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t NUM_TASKS = 1 << 16;
+constexpr std::size_t QUEUE_CAPACITY = 1 << 10;
+
+/** The baseline: a std::deque protected by a std::mutex. */
+class MutexQueue {
+public:
+    template <typename F>
+    bool try_push(F &&f) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace_back(std::forward<F>(f));
+
+        return true;
+    }
+
+    std::size_t invoke_all() {
+        std::size_t count = 0;
+
+        for (;;) {
+            fn2::UniqueFunction<void()> task;
+
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+
+                if (tasks_.empty()) {
+                    return count;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            task();
+            ++count;
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<fn2::UniqueFunction<void()>> tasks_;
+};
+
+// NUM_TASKS tasks are pushed by state.range(0) producers and invoked
+// by the benchmark thread
+template <typename Q>
+void push_invoke(benchmark::State &state, Q &queue) {
+    const auto num_producers = static_cast<std::size_t>(state.range(0));
+    const std::size_t tasks_per_producer = NUM_TASKS / num_producers;
+
+    for (auto _ : state) {
+        std::size_t sum = 0;
+        std::vector<std::thread> producers;
+
+        for (std::size_t i = 0; i < num_producers; ++i) {
+            producers.emplace_back([&queue, &sum, tasks_per_producer] {
+                for (std::size_t j = 0; j < tasks_per_producer; ++j) {
+                    while (!queue.try_push([&sum, j] { sum += j; })) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        for (std::size_t invoked = 0; invoked < tasks_per_producer * num_producers;) {
+            const std::size_t count = queue.invoke_all();
+
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+
+            invoked += count;
+        }
+
+        for (std::thread &producer : producers) {
+            producer.join();
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(
+        state.iterations() * (NUM_TASKS / num_producers) * num_producers
+    ));
+}
+
+void task_queue(benchmark::State &state) {
+    fn2::TaskQueue queue(QUEUE_CAPACITY);
+    push_invoke(state, queue);
+}
+
+void mutex_queue(benchmark::State &state) {
+    MutexQueue queue;
+    push_invoke(state, queue);
+}
+
+} // namespace
+
+BENCHMARK(task_queue)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK(mutex_queue)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
@@ -0,0 +1,207 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t NUM_TASKS = 1 << 16;
+
+/**
+ *  The baseline: workers sharing one std::deque of std::function
+ *  protected by a std::mutex and a std::condition_variable.
+ */
+class MutexPool {
+public:
+    explicit MutexPool(std::size_t num_threads) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            threads_.emplace_back([this] {
+                while (std::function<void()> task = pop(true)) {
+                    task();
+                }
+            });
+        }
+    }
+
+    ~MutexPool() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        cv_.notify_all();
+
+        for (std::thread &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    MutexPool(const MutexPool &other) = delete;
+    MutexPool &operator=(const MutexPool &other) = delete;
+
+    template <typename F>
+    void submit(F &&f) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back(std::forward<F>(f));
+        }
+
+        cv_.notify_one();
+    }
+
+    bool try_run_one() {
+        if (std::function<void()> task = pop(false)) {
+            task();
+
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    std::function<void()> pop(bool wait) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (wait) {
+            cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        }
+
+        if (tasks_.empty()) {
+            return nullptr;
+        }
+
+        std::function<void()> task = std::move(tasks_.front());
+        tasks_.pop_front();
+
+        return task;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// runs until count reaches target, helping the pool in the meantime
+template <typename P>
+void wait_for(P &pool, const std::atomic<std::size_t> &count, std::size_t target) {
+    while (count.load(std::memory_order_acquire) != target) {
+        if (!pool.try_run_one()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// splits [0, n) in halves until a single task is left, so that every
+// task but the first one is submitted by a task running on the pool
+template <typename P>
+void fan_out(P &pool, std::atomic<std::size_t> &count, std::size_t n) {
+    while (n > 1) {
+        const std::size_t half = n / 2;
+
+        pool.submit([&pool, &count, half] { fan_out(pool, count, half); });
+        n -= half;
+    }
+
+    count.fetch_add(1, std::memory_order_release);
+}
+
+// NUM_TASKS tasks submitted recursively by tasks
+template <typename P>
+void fork_join(benchmark::State &state) {
+    P pool(static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        std::atomic<std::size_t> count{0};
+
+        pool.submit([&pool, &count] { fan_out(pool, count, NUM_TASKS); });
+        wait_for(pool, count, NUM_TASKS);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_TASKS));
+}
+
+// NUM_TASKS tiny tasks submitted by the benchmark thread
+template <typename P>
+void submit_external(benchmark::State &state) {
+    P pool(static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        std::atomic<std::size_t> count{0};
+
+        for (std::size_t i = 0; i < NUM_TASKS; ++i) {
+            pool.submit([&count] { count.fetch_add(1, std::memory_order_release); });
+        }
+
+        wait_for(pool, count, NUM_TASKS);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * NUM_TASKS));
+}
+
+void thread_pool_fork_join(benchmark::State &state) {
+    fork_join<fn2::ThreadPool>(state);
+}
+
+void mutex_pool_fork_join(benchmark::State &state) {
+    fork_join<MutexPool>(state);
+}
+
+void thread_pool_submit(benchmark::State &state) {
+    submit_external<fn2::ThreadPool>(state);
+}
+
+void mutex_pool_submit(benchmark::State &state) {
+    submit_external<MutexPool>(state);
+}
+
+void thread_counts(benchmark::internal::Benchmark *b) {
+    const unsigned max = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned n = 1; n <= max; n *= 2) {
+        b->Arg(n);
+    }
+}
+
+} // namespace
+
+BENCHMARK(thread_pool_fork_join)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(mutex_pool_fork_join)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(thread_pool_submit)->Apply(thread_counts)->UseRealTime();
+BENCHMARK(mutex_pool_submit)->Apply(thread_counts)->UseRealTime();
@@ -0,0 +1,94 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_ALGORITHM_H
+#define FN2_ALGORITHM_H
+
+#include <fn2/fn2.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace fn2 {
+
+/**
+ *  Reorders [first, last) so that Functions which wrap objects of the
+ *  same type, stored in the same way, are adjacent. Empty Functions
+ *  are moved to the back. The relative order of Functions within each
+ *  group is preserved; the order of the groups is unspecified.
+ *
+ *  Sorting a range once after its Functions change, then invoking
+ *  [first, sort_by_target(first, last)) with a plain loop, invokes
+ *  each thunk back-to-back, which is friendlier to branch target
+ *  prediction and the instruction cache than an arbitrary order.
+ *  Since the range itself is reordered, this changes the order in
+ *  which its Functions are invoked, so a range whose order matters
+ *  must not be sorted.
+ *
+ *  @returns the end of the Functions that are not empty, which is the
+ *           first empty Function or last.
+ *
+ *  @throws any exceptions that moving the elements of [first, last)
+ *          throws. Moving a BasicFunction never throws.
+ */
+template <typename It>
+inline It sort_by_target(It first, It last);
+
+/**
+ *  Reorders [first, last) so that Functions which wrap objects of the
+ *  same type, stored in the same way, are adjacent. Empty Functions
+ *  are moved to the back. The relative order of Functions within each
+ *  group is preserved; the order of the groups is unspecified.
+ *
+ *  Sorting a range once after its Functions change, then invoking
+ *  [first, sort_by_target(first, last)) with a plain loop, invokes
+ *  each thunk back-to-back, which is friendlier to branch target
+ *  prediction and the instruction cache than an arbitrary order.
+ *  Since the range itself is reordered, this changes the order in
+ *  which its Functions are invoked, so a range whose order matters
+ *  must not be sorted.
+ *
+ *  @returns the end of the Functions that are not empty, which is the
+ *           first empty Function or last.
+ *
+ *  @throws any exceptions that moving the elements of [first, last)
+ *          throws. Moving a BasicFunction never throws.
+ */
+template <typename It>
+It sort_by_target(It first, It last) {
+    std::stable_sort(first, last, [](const auto &lhs, const auto &rhs) {
+        const void *const lhs_vptr = detail::FunctionAccess::vptr(lhs);
+        const void *const rhs_vptr = detail::FunctionAccess::vptr(rhs);
+
+        // empty Functions come last
+        return lhs_vptr && (!rhs_vptr || std::less<const void*>()(lhs_vptr, rhs_vptr));
+    });
+
+    return std::partition_point(first, last, [](const auto &f) {
+        return detail::FunctionAccess::vptr(f) != nullptr;
+    });
+}
+
+} // namespace fn2
+
+#endif
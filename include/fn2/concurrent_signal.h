@@ -0,0 +1,670 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_CONCURRENT_SIGNAL_H
+#define FN2_CONCURRENT_SIGNAL_H
+
+#include <fn2/fn2.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace fn2 {
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+template <typename S>
+class ConcurrentSignal;
+
+namespace detail {
+
+/**
+ *  The base of objects retired to the EpochDomain, linked into its
+ *  list of retired objects.
+ */
+struct EpochNode {
+    EpochNode *next = nullptr;
+    std::uint64_t epoch = 0;
+    void (*destroy)(EpochNode *node) noexcept = nullptr;
+};
+
+/** The epoch that one thread is pinned at. */
+struct alignas(CACHE_LINE_SIZE) EpochRecord {
+    // the epoch shifted left by one, ored with one if the thread is
+    // pinned; zero otherwise
+    std::atomic<std::uint64_t> state{0};
+    std::atomic<bool> in_use{true};
+    EpochRecord *next = nullptr;
+};
+
+/**
+ *  Epoch-based reclamation shared by all threads.
+ *
+ *  Readers pin the current epoch before loading a pointer to a shared
+ *  object and unpin it once they no longer use that object. An object
+ *  that writers have unpublished is retired with the epoch at that
+ *  time. The epoch only advances once every pinned thread has pinned
+ *  the current epoch, so once it has advanced twice, no thread can
+ *  still be reading the object and it is destroyed.
+ */
+class EpochDomain {
+public:
+    // the domain is never destroyed, so that objects can still be
+    // retired during static destruction
+    static EpochDomain& get() {
+        static EpochDomain *const domain = new EpochDomain();
+        return *domain;
+    }
+
+    std::uint64_t epoch() const noexcept {
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    // @returns a record that is not used by any other thread
+    EpochRecord* acquire_record() {
+        for (EpochRecord *record = records_.load(std::memory_order_acquire); record; record = record->next) {
+            bool expected = false;
+
+            if (!record->in_use.load(std::memory_order_relaxed)
+                && record->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+
+        // records are never freed, so that pinning never waits
+        auto *const record = new EpochRecord();
+        record->next = records_.load(std::memory_order_relaxed);
+
+        while (!records_.compare_exchange_weak(record->next, record,
+                                               std::memory_order_release, std::memory_order_relaxed)) { }
+
+        return record;
+    }
+
+    void release_record(EpochRecord *record) noexcept {
+        record->in_use.store(false, std::memory_order_release);
+    }
+
+    /**
+     *  Destroys node once no thread can still be reading it, along with
+     *  any other retired nodes that can no longer be read.
+     *
+     *  @param node must no longer be reachable by threads that pin an
+     *         epoch after this call.
+     */
+    void retire(EpochNode *node) noexcept {
+        EpochNode *ready = nullptr;
+
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+
+            node->epoch = epoch_.load(std::memory_order_relaxed);
+            node->next = retired_;
+            retired_ = node;
+
+            // with no thread pinned, node can be destroyed immediately
+            for (int i = 0; i < 2 && try_advance(); ++i) { }
+
+            // retired_ is ordered from newest to oldest
+            const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+
+            for (EpochNode **link = &retired_; *link; link = &(*link)->next) {
+                if ((*link)->epoch + 2 <= epoch) {
+                    ready = std::exchange(*link, nullptr);
+
+                    break;
+                }
+            }
+        }
+
+        // destructors may retire more nodes
+        while (ready) {
+            EpochNode *const next = ready->next;
+            ready->destroy(ready);
+            ready = next;
+        }
+    }
+
+private:
+    EpochDomain() noexcept = default;
+
+    // mutex_ must be held
+    bool try_advance() noexcept {
+        const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+
+        // pairs with the fence in epoch_pin, so that either a pinning
+        // thread sees the unpublished pointer or this thread sees it
+        // pinned
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        for (const EpochRecord *record = records_.load(std::memory_order_acquire); record; record = record->next) {
+            // pairs with the release store in epoch_unpin, so that reads
+            // by unpinned threads happen before nodes are destroyed
+            const std::uint64_t state = record->state.load(std::memory_order_acquire);
+
+            if ((state & 1) && (state >> 1) != epoch) {
+                return false;
+            }
+        }
+
+        epoch_.store(epoch + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    std::atomic<std::uint64_t> epoch_{0};
+    std::atomic<EpochRecord*> records_{nullptr};
+    std::mutex mutex_;
+    EpochNode *retired_ = nullptr;
+};
+
+/** The record of one thread and how many times it is pinned. */
+struct EpochThread {
+    enum class State : unsigned char {
+        // the thread has not pinned an epoch yet
+        Unregistered,
+        Active,
+        // the thread is exiting and its record was released
+        Closed,
+    };
+
+    EpochRecord *record;
+    std::size_t depth;
+    State state;
+};
+
+// trivially destructible, so that it can be used until the thread exits
+inline thread_local EpochThread EPOCH_THREAD{};
+
+/** Releases the calling thread's record on exit. */
+struct EpochThreadCloser {
+    // odr-using this object registers its destructor
+    void open() noexcept {
+        EPOCH_THREAD.state = EpochThread::State::Active;
+    }
+
+    ~EpochThreadCloser() {
+        EpochThread &thread = EPOCH_THREAD;
+        EpochDomain::get().release_record(thread.record);
+        thread.record = nullptr;
+        thread.state = EpochThread::State::Closed;
+    }
+};
+
+inline thread_local EpochThreadCloser EPOCH_THREAD_CLOSER;
+
+inline void epoch_register(EpochThread &thread) {
+    thread.record = EpochDomain::get().acquire_record();
+
+    // a record acquired after the thread was closed is never released
+    if (thread.state == EpochThread::State::Unregistered) {
+        EPOCH_THREAD_CLOSER.open();
+    }
+}
+
+/**
+ *  Pins the current epoch until a matching call to epoch_unpin. Calls
+ *  may be nested. Wait-free once the calling thread has a record.
+ *
+ *  @throws std::bad_alloc if the calling thread needs a new record.
+ */
+inline void epoch_pin() {
+    EpochThread &thread = EPOCH_THREAD;
+
+    if (thread.depth > 0) {
+        ++thread.depth;
+
+        return;
+    }
+
+    if (!thread.record) {
+        epoch_register(thread);
+    }
+
+    const std::uint64_t epoch = EpochDomain::get().epoch();
+    thread.record->state.store(epoch << 1 | 1, std::memory_order_relaxed);
+
+    // pairs with the fence in EpochDomain::try_advance
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    thread.depth = 1;
+}
+
+/** Unpins the epoch pinned by the matching call to epoch_pin. */
+inline void epoch_unpin() noexcept {
+    EpochThread &thread = EPOCH_THREAD;
+
+    if (--thread.depth == 0) {
+        thread.record->state.store(0, std::memory_order_release);
+    }
+}
+
+} // namespace detail
+#endif
+
+/**
+ *  ConcurrentSignal invokes every connected slot when it is emitted,
+ *  and may be emitted by any number of threads while slots are
+ *  connected and disconnected.
+ *
+ *  The connected slots are an immutable, contiguous array of Function
+ *  objects. Emitting takes a Snapshot of the current array without
+ *  locking or writing to memory shared with other threads, so
+ *  emission scales with the number of emitting threads. Connecting or
+ *  disconnecting a slot copies the array, publishes the copy and
+ *  retires the old array, which is destroyed once no thread can
+ *  still be emitting it. Connecting and disconnecting are serialized
+ *  by a mutex and take time linear in the number of slots, so they
+ *  should be rare compared to emission.
+ *
+ *  Slots are invoked concurrently when multiple threads emit, so they
+ *  must be invocable as const lvalues, and doing so must be safe to do
+ *  concurrently. Slots may connect, disconnect and emit while being
+ *  invoked; a slot that is disconnected during emission may still be
+ *  invoked by emissions that took their Snapshot earlier.
+ *
+ *  Disconnecting a slot does not destroy it. Its array is destroyed,
+ *  along with the slots in it, by whichever thread next retires an
+ *  array once no Snapshot of it remains: a later call to connect,
+ *  disconnect or clear on any ConcurrentSignal, on any thread. Slot
+ *  destructors must therefore not depend on the thread they run on or
+ *  on running before disconnect returns.
+ *
+ *  ConcurrentSignal is neither copyable nor movable.
+ */
+template <typename ...As, bool NX>
+class ConcurrentSignal<void(As...) noexcept(NX)> {
+    struct Version;
+
+public:
+    /**
+     *  The type of each slot. Slots are invoked through a const
+     *  reference, since multiple threads may invoke the same slot.
+     */
+    using Slot = Function<void(As...) const noexcept(NX)>;
+
+    /** Identifies a connected slot, so that it can be disconnected. */
+    class Connection {
+    public:
+        /** @returns a Connection that identifies no slot. */
+        Connection() noexcept = default;
+
+    private:
+        friend ConcurrentSignal;
+
+        constexpr explicit Connection(std::uint64_t id) noexcept : id_(id) { }
+
+        std::uint64_t id_ = 0;
+    };
+
+    /**
+     *  Snapshot is the array of slots that were connected when it was
+     *  taken. The array is not destroyed while a Snapshot of it exists.
+     */
+    class Snapshot {
+    public:
+        /** Allows the array of slots to be destroyed. */
+        inline ~Snapshot();
+
+        Snapshot(const Snapshot &other) = delete;
+
+        Snapshot& operator=(const Snapshot &other) = delete;
+
+        /** @returns a pointer to the first slot. */
+        inline const Slot* begin() const noexcept;
+
+        /** @returns a pointer past the last slot. */
+        inline const Slot* end() const noexcept;
+
+        /** @returns the number of slots. */
+        inline std::size_t size() const noexcept;
+
+        /** @returns true if there are no slots. */
+        inline bool empty() const noexcept;
+
+    private:
+        friend ConcurrentSignal;
+
+        inline explicit Snapshot(const ConcurrentSignal &signal);
+
+        const Version *version_;
+    };
+
+    /** @returns a ConcurrentSignal with no connected slots. */
+    ConcurrentSignal() noexcept = default;
+
+    /**
+     *  Destroys the connected slots. Must not be called while this
+     *  ConcurrentSignal is being emitted.
+     */
+    inline ~ConcurrentSignal();
+
+    ConcurrentSignal(const ConcurrentSignal &other) = delete;
+
+    ConcurrentSignal& operator=(const ConcurrentSignal &other) = delete;
+
+    /**
+     *  Thread-safe. If an exception is thrown, this ConcurrentSignal
+     *  will remain unchanged.
+     *
+     *  @param f must not be a null pointer.
+     *  @tparam Slot must be constructible from (F).
+     *  @returns a Connection that identifies a new slot constructed
+     *           from (std::forward<F>(f)).
+     *
+     *  @throws std::bad_alloc
+     *  @throws any exceptions that the constructor of Slot or the copy
+     *          constructors of the connected slots throw.
+     */
+    template <typename F>
+    inline Connection connect(F &&f);
+
+    /**
+     *  Disconnects the slot identified by connection, if there is one.
+     *  Thread-safe. If an exception is thrown, this ConcurrentSignal
+     *  will remain unchanged.
+     *
+     *  @returns true if a slot was disconnected.
+     *
+     *  @throws std::bad_alloc
+     *  @throws any exceptions that the copy constructors of the
+     *          connected slots throw.
+     */
+    inline bool disconnect(Connection connection);
+
+    /** Disconnects all slots. Thread-safe. */
+    inline void clear() noexcept;
+
+    /**
+     *  Wait-free once the calling thread has taken a Snapshot of any
+     *  ConcurrentSignal. Thread-safe.
+     *
+     *  @returns a Snapshot of the connected slots.
+     *
+     *  @throws std::bad_alloc if this is the first Snapshot taken by
+     *          the calling thread.
+     */
+    inline Snapshot snapshot() const;
+
+    /**
+     *  Invokes each slot in a Snapshot of the connected slots with the
+     *  lvalue arguments (as...). Thread-safe.
+     *
+     *  @throws std::bad_alloc if this is the first Snapshot taken by
+     *          the calling thread.
+     *  @throws any exceptions that the slots throw. Slots after the
+     *          one that threw are not invoked.
+     */
+    inline void emit(As ...as) const;
+
+    /** @returns true if connection identifies a connected slot. */
+    inline bool connected(Connection connection) const;
+
+    /** @returns the number of connected slots. */
+    inline std::size_t size() const;
+
+private:
+    // ids are in increasing order
+    struct Version : detail::EpochNode {
+        std::vector<Slot> slots;
+        std::vector<std::uint64_t> ids;
+    };
+
+    inline static void destroy(detail::EpochNode *node) noexcept;
+
+    inline Version* publish(Version *version) noexcept;
+
+    inline static void retire(Version *version) noexcept;
+
+    std::atomic<Version*> version_{nullptr};
+    std::mutex mutex_;
+    std::uint64_t next_id_ = 1;
+};
+
+/** Allows the array of slots to be destroyed. */
+template <typename ...As, bool NX>
+ConcurrentSignal<void(As...) noexcept(NX)>::Snapshot::~Snapshot() {
+    detail::epoch_unpin();
+}
+
+/** @returns a pointer to the first slot. */
+template <typename ...As, bool NX>
+auto ConcurrentSignal<void(As...) noexcept(NX)>::Snapshot::begin() const noexcept -> const Slot* {
+    return version_ ? version_->slots.data() : nullptr;
+}
+
+/** @returns a pointer past the last slot. */
+template <typename ...As, bool NX>
+auto ConcurrentSignal<void(As...) noexcept(NX)>::Snapshot::end() const noexcept -> const Slot* {
+    return version_ ? version_->slots.data() + version_->slots.size() : nullptr;
+}
+
+/** @returns the number of slots. */
+template <typename ...As, bool NX>
+std::size_t ConcurrentSignal<void(As...) noexcept(NX)>::Snapshot::size() const noexcept {
+    return version_ ? version_->slots.size() : 0;
+}
+
+/** @returns true if there are no slots. */
+template <typename ...As, bool NX>
+bool ConcurrentSignal<void(As...) noexcept(NX)>::Snapshot::empty() const noexcept {
+    return size() == 0;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+template <typename ...As, bool NX>
+ConcurrentSignal<void(As...) noexcept(NX)>::Snapshot::Snapshot(const ConcurrentSignal &signal) {
+    detail::epoch_pin();
+
+    // pairs with the exchange in publish, so that the array is visible
+    version_ = signal.version_.load(std::memory_order_acquire);
+}
+#endif
+
+/**
+ *  Destroys the connected slots. Must not be called while this
+ *  ConcurrentSignal is being emitted.
+ */
+template <typename ...As, bool NX>
+ConcurrentSignal<void(As...) noexcept(NX)>::~ConcurrentSignal() {
+    delete version_.load(std::memory_order_relaxed);
+}
+
+/**
+ *  Thread-safe. If an exception is thrown, this ConcurrentSignal will
+ *  remain unchanged.
+ *
+ *  @param f must not be a null pointer.
+ *  @tparam Slot must be constructible from (F).
+ *  @returns a Connection that identifies a new slot constructed from
+ *           (std::forward<F>(f)).
+ *
+ *  @throws std::bad_alloc
+ *  @throws any exceptions that the constructor of Slot or the copy
+ *          constructors of the connected slots throw.
+ */
+template <typename ...As, bool NX>
+template <typename F>
+auto ConcurrentSignal<void(As...) noexcept(NX)>::connect(F &&f) -> Connection {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const Version *const current = version_.load(std::memory_order_relaxed);
+    const std::size_t size = current ? current->slots.size() : 0;
+
+    auto next = std::make_unique<Version>();
+    next->destroy = &ConcurrentSignal::destroy;
+    next->slots.reserve(size + 1);
+    next->ids.reserve(size + 1);
+
+    if (current) {
+        next->slots.insert(next->slots.end(), current->slots.begin(), current->slots.end());
+        next->ids = current->ids;
+    }
+
+    next->slots.emplace_back(std::forward<F>(f));
+    next->ids.push_back(next_id_);
+
+    const Connection connection(next_id_++);
+    Version *const old = publish(next.release());
+    lock.unlock();
+    retire(old);
+
+    return connection;
+}
+
+/**
+ *  Disconnects the slot identified by connection, if there is one.
+ *  Thread-safe. If an exception is thrown, this ConcurrentSignal will
+ *  remain unchanged.
+ *
+ *  @returns true if a slot was disconnected.
+ *
+ *  @throws std::bad_alloc
+ *  @throws any exceptions that the copy constructors of the connected
+ *          slots throw.
+ */
+template <typename ...As, bool NX>
+bool ConcurrentSignal<void(As...) noexcept(NX)>::disconnect(Connection connection) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const Version *const current = version_.load(std::memory_order_relaxed);
+
+    if (!current) {
+        return false;
+    }
+
+    const auto found = std::lower_bound(current->ids.begin(), current->ids.end(), connection.id_);
+
+    if (found == current->ids.end() || *found != connection.id_) {
+        return false;
+    }
+
+    std::unique_ptr<Version> next;
+
+    if (current->ids.size() > 1) {
+        next = std::make_unique<Version>();
+        next->destroy = &ConcurrentSignal::destroy;
+        next->slots.reserve(current->slots.size() - 1);
+        next->ids.reserve(current->ids.size() - 1);
+
+        const auto index = static_cast<std::size_t>(found - current->ids.begin());
+
+        for (std::size_t i = 0; i < current->slots.size(); ++i) {
+            if (i != index) {
+                next->slots.push_back(current->slots[i]);
+                next->ids.push_back(current->ids[i]);
+            }
+        }
+    }
+
+    Version *const old = publish(next.release());
+    lock.unlock();
+    retire(old);
+
+    return true;
+}
+
+/** Disconnects all slots. Thread-safe. */
+template <typename ...As, bool NX>
+void ConcurrentSignal<void(As...) noexcept(NX)>::clear() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Version *const old = publish(nullptr);
+    lock.unlock();
+    retire(old);
+}
+
+/**
+ *  Wait-free once the calling thread has taken a Snapshot of any
+ *  ConcurrentSignal. Thread-safe.
+ *
+ *  @returns a Snapshot of the connected slots.
+ *
+ *  @throws std::bad_alloc if this is the first Snapshot taken by the
+ *          calling thread.
+ */
+template <typename ...As, bool NX>
+auto ConcurrentSignal<void(As...) noexcept(NX)>::snapshot() const -> Snapshot {
+    return Snapshot(*this);
+}
+
+/**
+ *  Invokes each slot in a Snapshot of the connected slots with the
+ *  lvalue arguments (as...). Thread-safe.
+ *
+ *  @throws std::bad_alloc if this is the first Snapshot taken by the
+ *          calling thread.
+ *  @throws any exceptions that the slots throw. Slots after the one
+ *          that threw are not invoked.
+ */
+template <typename ...As, bool NX>
+void ConcurrentSignal<void(As...) noexcept(NX)>::emit(As ...as) const {
+    const Snapshot snapshot(*this);
+
+    for (const Slot &slot : snapshot) {
+        slot(as...);
+    }
+}
+
+/** @returns true if connection identifies a connected slot. */
+template <typename ...As, bool NX>
+bool ConcurrentSignal<void(As...) noexcept(NX)>::connected(Connection connection) const {
+    const Snapshot snapshot(*this);
+
+    return snapshot.version_
+           && std::binary_search(snapshot.version_->ids.begin(), snapshot.version_->ids.end(), connection.id_);
+}
+
+/** @returns the number of connected slots. */
+template <typename ...As, bool NX>
+std::size_t ConcurrentSignal<void(As...) noexcept(NX)>::size() const {
+    return Snapshot(*this).size();
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+template <typename ...As, bool NX>
+void ConcurrentSignal<void(As...) noexcept(NX)>::destroy(detail::EpochNode *node) noexcept {
+    delete static_cast<Version*>(node);
+}
+
+// mutex_ must be held. returns the previous version, which must be
+// retired once mutex_ is released, since retiring may destroy slots
+template <typename ...As, bool NX>
+auto ConcurrentSignal<void(As...) noexcept(NX)>::publish(Version *version) noexcept -> Version* {
+    // the exchange precedes the fence in EpochDomain::try_advance, so
+    // threads that pin after old is retired see version
+    return version_.exchange(version, std::memory_order_acq_rel);
+}
+
+template <typename ...As, bool NX>
+void ConcurrentSignal<void(As...) noexcept(NX)>::retire(Version *version) noexcept {
+    if (version) {
+        detail::EpochDomain::get().retire(version);
+    }
+}
+#endif
+
+} // namespace fn2
+
+#endif
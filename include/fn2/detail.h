@@ -24,8 +24,19 @@
 #ifndef FN2_DETAIL_H
 #define FN2_DETAIL_H
 
+#include <fn2/slab_allocator.h>
+#include <fn2/traits.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <type_traits>
+#include <typeinfo>
 #include <utility>
 
 namespace fn2::detail {
@@ -38,69 +49,714 @@ template <typename ...Ts>
 template <typename ...Ts>
 Overload(Ts...) -> Overload<Ts...>;
 
-template <typename R, typename ...As>
-struct Vtable {
-    R (*invoke)(void *self, As ...as);
+/**
+ *  The type used to pass an argument of type T through a thunk.
+ *
+ *  References and small trivially copyable types are passed unchanged.
+ *  Everything else is passed by rvalue reference, so an argument that
+ *  was passed by value to Function::operator() is moved or copied
+ *  only once more: into the parameter of the wrapped object.
+ */
+template <typename T>
+using Param = std::conditional_t<
+    std::is_reference_v<T>
+    || (std::is_trivially_copyable_v<T> && sizeof(T) <= 2 * sizeof(void*)),
+    T,
+    std::add_rvalue_reference_t<T>
+>;
+
+/** Where a type-erased object is stored. */
+enum class Location {
+    /** The object is stored in a buffer. */
+    Inline,
+    /** The buffer stores a pointer to an object on the free store. */
+    Heap,
+    /**
+     *  The buffer stores a pointer to a reference counted object on the
+     *  free store, whose count is atomic.
+     */
+    Shared,
+    /** As Shared, but the reference count is not atomic. */
+    LocalShared,
+};
+
+/**
+ *  Counts of the storage operations on wrapped objects of one type.
+ *  The counters of every type that has been counted at least once
+ *  form a list, so that they can be enumerated.
+ */
+struct StorageCounters {
+    using Counter = std::atomic<std::uint64_t> StorageCounters::*;
+
+    constexpr StorageCounters(const char *(*n)() noexcept, std::size_t s, std::size_t a) noexcept
+    : name(n), size(s), align(a) { }
+
+    void add(Counter counter, std::uint64_t n) noexcept {
+        if (!registered.load(std::memory_order_acquire)
+            && !registered.exchange(true, std::memory_order_acq_rel)) {
+            next = head.load(std::memory_order_relaxed);
+
+            while (!head.compare_exchange_weak(next, this, std::memory_order_release,
+                                               std::memory_order_relaxed)) { }
+        }
+
+        (this->*counter).fetch_add(n, std::memory_order_relaxed);
+    }
+
+    const char *(*name)() noexcept;
+    std::size_t size;
+    std::size_t align;
+
+    std::atomic<std::uint64_t> inline_constructions{0};
+    std::atomic<std::uint64_t> heap_constructions{0};
+    std::atomic<std::uint64_t> clones{0};
+    std::atomic<std::uint64_t> moves{0};
+    std::atomic<std::uint64_t> bytes_allocated{0};
+
+    std::atomic<bool> registered{false};
+    StorageCounters *next = nullptr;
+
+    static inline std::atomic<StorageCounters*> head{nullptr};
+};
+
+template <typename F>
+const char* type_name() noexcept {
+    return typeid(F).name();
+}
+
+/** The storage counters of wrapped objects of type F. */
+template <typename F>
+inline StorageCounters STORAGE_COUNTERS{&type_name<F>, sizeof(F), alignof(F)};
+
+/**
+ *  Adds n to one of the storage counters of F if FN2_INSTRUMENT is
+ *  defined; otherwise does nothing.
+ */
+template <typename F>
+void count_storage([[maybe_unused]] StorageCounters::Counter counter,
+                   [[maybe_unused]] std::uint64_t n = 1) noexcept {
+#ifdef FN2_INSTRUMENT
+    STORAGE_COUNTERS<F>.add(counter, n);
+#endif
+}
+
+/**
+ *  Adds one to one of the storage counters of the type wrapped by a
+ *  BasicFunction whose vtable is vptr, unless vptr is null, if
+ *  FN2_INSTRUMENT is defined; otherwise does nothing.
+ */
+template <typename V>
+void count_storage([[maybe_unused]] const V *vptr,
+                   [[maybe_unused]] StorageCounters::Counter counter) noexcept {
+#ifdef FN2_INSTRUMENT
+    if (vptr) {
+        vptr->counters->add(counter, 1);
+    }
+#endif
+}
+
+/**
+ *  The properties of a signature S, which is a function type R(As...)
+ *  that may be qualified with const or && and may be noexcept.
+ */
+template <typename S>
+struct Signature;
+
+template <typename R, typename ...As, bool NX>
+struct Signature<R(As...) noexcept(NX)> {
+    // the unqualified signature of an invoke thunk
+    using Invoke = R(As...) noexcept(NX);
+
+    // the type that a wrapped object of type F is invoked as
+    template <typename F>
+    using Target = F&;
+
+    static constexpr bool IS_CONST = false;
+    static constexpr bool IS_RVALUE = false;
+};
+
+template <typename R, typename ...As, bool NX>
+struct Signature<R(As...) const noexcept(NX)> {
+    using Invoke = R(As...) noexcept(NX);
+
+    template <typename F>
+    using Target = const F&;
+
+    static constexpr bool IS_CONST = true;
+    static constexpr bool IS_RVALUE = false;
+};
+
+template <typename R, typename ...As, bool NX>
+struct Signature<R(As...) && noexcept(NX)> {
+    using Invoke = R(As...) noexcept(NX);
+
+    template <typename F>
+    using Target = F&&;
+
+    static constexpr bool IS_CONST = false;
+    static constexpr bool IS_RVALUE = true;
+};
+
+/**
+ *  Operations on a buffer that holds a type-erased object that may only
+ *  be moved. Each operation knows where the object is stored.
+ *
+ *  destroy and relocate are null if they are trivial, in which case
+ *  callers should do nothing or use std::memcpy, respectively.
+ *  relocate is always null for objects on the free store, since the
+ *  buffer holds a pointer.
+ */
+template <typename S>
+struct MoveVtable;
+
+template <typename R, typename ...As, bool NX>
+struct MoveVtable<R(As...) noexcept(NX)> {
+    R (*invoke)(void *self, Param<As> ...as) noexcept(NX);
     void (*destroy)(void *self) noexcept;
-    void (*destroy_dealloc)(void *self) noexcept;
-    void (*copy)(void *self, const void *other);
-    void (*move)(void *self, void *other) noexcept;
+    // move constructs into self, then destroys other
+    void (*relocate)(void *self, void *other) noexcept;
     void (*swap)(void *self, void *other) noexcept;
-    void* (*clone)(const void *self);
+    // where the wrapped object is stored
+    Location location;
+    // if the object is on the free store in a block from a slab of the
+    // default allocator, the size of that block; otherwise zero
+    std::size_t block_size;
+    // destroys the object on the free store and returns its block
+    // without freeing it; null if block_size is zero
+    void* (*detach)(void *self) noexcept;
+#ifdef FN2_INSTRUMENT
+    StorageCounters *counters;
+#endif
+};
+
+/**
+ *  Operations on a buffer that holds a type-erased object that may be
+ *  copied and moved.
+ *
+ *  copy is null if it is trivial, in which case callers should use
+ *  std::memcpy.
+ */
+template <typename S>
+struct Vtable : MoveVtable<S> {
+    void (*copy)(void *self, const void *other);
 };
 
-template <typename F, typename R, typename ...As>
-static const Vtable<R, As...>& get_vtbl() noexcept {
+/** The allocator used when none is provided. */
+using DefaultAllocator = SlabAllocator<std::byte>;
+
+/**
+ *  @returns alloc rebound to std::byte, or a polymorphic allocator
+ *           that uses alloc if alloc is a pointer to a memory resource.
+ */
+template <typename A>
+auto to_byte_allocator(const A &alloc) noexcept {
+    if constexpr (std::is_convertible_v<const A&, std::pmr::memory_resource*>) {
+        return std::pmr::polymorphic_allocator<std::byte>(alloc);
+    } else {
+        return typename std::allocator_traits<A>::template rebind_alloc<std::byte>(alloc);
+    }
+}
+
+template <typename A, bool = std::is_empty_v<A> && !std::is_final_v<A>>
+class AllocatorHolder {
+public:
+    explicit AllocatorHolder(const A &alloc) noexcept : alloc_(alloc) { }
+
+    const A& allocator() const noexcept {
+        return alloc_;
+    }
+
+private:
+    A alloc_;
+};
+
+// empty allocators take no space
+template <typename A>
+class AllocatorHolder<A, true> : A {
+public:
+    explicit AllocatorHolder(const A &alloc) noexcept : A(alloc) { }
+
+    const A& allocator() const noexcept {
+        return *this;
+    }
+};
+
+/**
+ *  An object on the free store, allocated by and holding a copy of an
+ *  allocator rebound from Alloc.
+ */
+template <typename F, typename Alloc>
+class Box : AllocatorHolder<typename std::allocator_traits<Alloc>::template rebind_alloc<Box<F, Alloc>>> {
+public:
+    using Allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<Box>;
+
+    template <typename ...Ts>
+    static Box* make(const Allocator &alloc, Ts &&...ts) {
+        Allocator a(alloc);
+        Box *const box = Traits::allocate(a, 1);
+
+        try {
+            new (box) Box(a, std::forward<Ts>(ts)...);
+        } catch (...) {
+            Traits::deallocate(a, box, 1);
+
+            throw;
+        }
+
+        return box;
+    }
+
+    static void destroy_dealloc(void *self) noexcept {
+        Box *const box = static_cast<Box*>(self);
+        Allocator a(box->allocator());
+
+        box->~Box();
+        Traits::deallocate(a, box, 1);
+    }
+
+    static void* clone(const void *self) {
+        const Box &box = *static_cast<const Box*>(self);
+
+        return make(box.allocator(), box.obj_);
+    }
+
+    // constructs a Box in block, which must fit one
+    template <typename ...Ts>
+    static Box* make_at(void *block, const Allocator &alloc, Ts &&...ts)
+    noexcept(std::is_nothrow_constructible_v<F, Ts...>) {
+        return new (block) Box(alloc, std::forward<Ts>(ts)...);
+    }
+
+    // destroys the Box at self, but does not free it
+    static void* destroy(void *self) noexcept {
+        static_cast<Box*>(self)->~Box();
+
+        return self;
+    }
+
+    static F& get(void *self) noexcept {
+        return static_cast<Box*>(self)->obj_;
+    }
+
+private:
+    using Traits = std::allocator_traits<Allocator>;
+
     static_assert(
-        std::is_invocable_r_v<R, F&, As...>,
-        "F& must be invocable with arguments (As...) to return type R"
+        std::is_same_v<typename Traits::pointer, Box*>,
+        "allocators with fancy pointers are not supported"
     );
-    static_assert(std::is_nothrow_destructible_v<F>, "F must be nothrow destructible");
-    static_assert(std::is_copy_constructible_v<F>, "F must be copy constructible");
-    static_assert(std::is_nothrow_move_constructible_v<F>, "F must be nothrow move constructible");
 
-    static const Vtable<R, As...> vtbl = {
-        [](void *self, As ...as) -> R {
-            return std::invoke(*static_cast<F*>(self), std::forward<As>(as)...);
-        },
-        [](void *self) noexcept {
-            static_cast<F*>(self)->F::~F();
-        },
-        [](void *self) noexcept {
-            delete static_cast<F*>(self);
-        },
-        [](void *self, const void *other) {
-            new (self) F(*static_cast<const F*>(other));
-        },
-        [](void *self, void *other) noexcept {
-            new (self) F(std::move(*static_cast<F*>(other)));
-        },
-        [](void *self, void *other) noexcept {
-            F &lhs = *static_cast<F*>(self);
-            F &rhs = *static_cast<F*>(other);
-
-            if constexpr (std::is_nothrow_swappable_v<F>) {
-                using std::swap;
-
-                swap(lhs, rhs);
-            } else {
-                F temp(std::move(rhs));
-
-                rhs.F::~F();
-                new (other) F(std::move(lhs));
-
-                lhs.F::~F();
-                new (self) F(std::move(temp));
+    template <typename ...Ts>
+    Box(const Allocator &alloc, Ts &&...ts)
+    : AllocatorHolder<Allocator>(alloc), obj_(std::forward<Ts>(ts)...) { }
+
+    F obj_;
+};
+
+/**
+ *  An F and the number of BasicFunctions that share it. If IsAtomic,
+ *  the count may be modified by several threads at once.
+ */
+template <typename F, bool IsAtomic>
+struct Counted {
+    template <typename ...Ts>
+    explicit Counted(Ts &&...ts) : obj(std::forward<Ts>(ts)...) { }
+
+    std::conditional_t<IsAtomic, std::atomic<std::size_t>, std::size_t> count{1};
+    F obj;
+};
+
+/**
+ *  Invokes a type-erased object as T, a reference to the object's
+ *  type, with signature S.
+ */
+template <typename T, typename S>
+struct Thunks;
+
+template <typename T, typename R, typename ...As, bool NX>
+struct Thunks<T, R(As...) noexcept(NX)> {
+    using F = std::remove_cv_t<std::remove_reference_t<T>>;
+
+    static_assert(
+        std::is_invocable_r_v<R, T, As...>,
+        "T must be invocable with arguments (As...) to return type R"
+    );
+    static_assert(
+        !NX || std::is_nothrow_invocable_r_v<R, T, As...>,
+        "T must be nothrow invocable with arguments (As...) to return type R"
+    );
+
+    static R invoke(void *self, Param<As> ...as) noexcept(NX) {
+        return std::invoke(static_cast<T>(*static_cast<F*>(self)), std::forward<As>(as)...);
+    }
+
+    template <typename A>
+    static R invoke_heap(void *self, Param<As> ...as) noexcept(NX) {
+        return invoke(&Box<F, A>::get(*static_cast<void**>(self)), std::forward<As>(as)...);
+    }
+
+    template <typename A, bool IsAtomic>
+    static R invoke_shared(void *self, Param<As> ...as) noexcept(NX) {
+        using B = Box<Counted<F, IsAtomic>, A>;
+
+        return invoke(&B::get(*static_cast<void**>(self)).obj, std::forward<As>(as)...);
+    }
+
+    template <Location L, typename A>
+    static constexpr auto invoke_at() noexcept {
+        if constexpr (L == Location::Inline) {
+            return &invoke;
+        } else if constexpr (L == Location::Heap) {
+            return &invoke_heap<A>;
+        } else {
+            return &invoke_shared<A, L == Location::Shared>;
+        }
+    }
+};
+
+/** Operations on a buffer that holds an F. */
+template <typename F>
+struct InlineOps {
+    static void destroy(void *self) noexcept {
+        static_cast<F*>(self)->F::~F();
+    }
+
+    static void relocate(void *self, void *other) noexcept {
+        F &src = *static_cast<F*>(other);
+
+        new (self) F(std::move(src));
+        src.F::~F();
+    }
+
+    static void swap(void *self, void *other) noexcept {
+        F &lhs = *static_cast<F*>(self);
+        F &rhs = *static_cast<F*>(other);
+
+        if constexpr (std::is_nothrow_swappable_v<F>) {
+            using std::swap;
+
+            swap(lhs, rhs);
+        } else {
+            F temp(std::move(rhs));
+
+            rhs.F::~F();
+            new (other) F(std::move(lhs));
+
+            lhs.F::~F();
+            new (self) F(std::move(temp));
+        }
+    }
+
+    static void copy(void *self, const void *other) {
+        new (self) F(*static_cast<const F*>(other));
+    }
+};
+
+/** Operations on a buffer that holds a pointer to a Box<F, A>. */
+template <typename F, typename A>
+struct HeapOps {
+    static void destroy(void *self) noexcept {
+        Box<F, A>::destroy_dealloc(*static_cast<void**>(self));
+    }
+
+    static void swap(void *self, void *other) noexcept {
+        std::swap(*static_cast<void**>(self), *static_cast<void**>(other));
+    }
+
+    static void copy(void *self, const void *other) {
+        *static_cast<void**>(self) = Box<F, A>::clone(*static_cast<void *const*>(other));
+        count_storage<F>(&StorageCounters::bytes_allocated, sizeof(Box<F, A>));
+    }
+
+    static void* detach(void *self) noexcept {
+        return Box<F, A>::destroy(*static_cast<void**>(self));
+    }
+};
+
+/**
+ *  Operations on a buffer that holds a pointer to a Box<Counted<F,
+ *  IsAtomic>, A>. Copies share the box, which is destroyed along with
+ *  the last of them.
+ */
+template <typename F, typename A, bool IsAtomic>
+struct SharedOps {
+    using B = Box<Counted<F, IsAtomic>, A>;
+
+    static void destroy(void *self) noexcept {
+        void *const box = *static_cast<void**>(self);
+        Counted<F, IsAtomic> &counted = B::get(box);
+
+        if constexpr (IsAtomic) {
+            // acquire so that the last owner sees every other owner's
+            // accesses to the object before destroying it
+            if (counted.count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
             }
-        },
-        [](const void *self) -> void* {
-            return new F(*static_cast<const F*>(self));
+        } else if (--counted.count != 0) {
+            return;
+        }
+
+        B::destroy_dealloc(box);
+    }
+
+    static void swap(void *self, void *other) noexcept {
+        std::swap(*static_cast<void**>(self), *static_cast<void**>(other));
+    }
+
+    static void copy(void *self, const void *other) noexcept {
+        void *const box = *static_cast<void *const*>(other);
+        Counted<F, IsAtomic> &counted = B::get(box);
+
+        if constexpr (IsAtomic) {
+            counted.count.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ++counted.count;
+        }
+
+        *static_cast<void**>(self) = box;
+    }
+};
+
+/** The operations on a buffer, or null where they are trivial. */
+template <typename F, Location L, typename A>
+struct Ops {
+    using Base = std::conditional_t<
+        L == Location::Inline,
+        InlineOps<F>,
+        std::conditional_t<L == Location::Heap, HeapOps<F, A>, SharedOps<F, A, L == Location::Shared>>
+    >;
+
+    static constexpr bool IS_INLINE = L == Location::Inline;
+
+    static constexpr auto destroy_or_null() noexcept {
+        return IS_INLINE && std::is_trivially_destructible_v<F> ? nullptr : &Base::destroy;
+    }
+
+    static constexpr auto relocate_or_null() noexcept {
+        if constexpr (IS_INLINE && !is_trivially_relocatable_v<F>) {
+            return &InlineOps<F>::relocate;
+        } else {
+            return static_cast<void (*)(void*, void*) noexcept>(nullptr);
+        }
+    }
+
+    static constexpr auto copy_or_null() noexcept {
+        return IS_INLINE && std::is_trivially_copyable_v<F> ? nullptr : &Base::copy;
+    }
+
+    // blocks are only reused if they come from the default allocator,
+    // which can free them without knowing the type they held
+    static constexpr std::size_t block_size() noexcept {
+        if constexpr (L == Location::Heap && std::is_same_v<A, DefaultAllocator>) {
+            return slab_block_size<Box<F, A>>();
+        } else {
+            return 0;
+        }
+    }
+
+    static constexpr auto detach_or_null() noexcept {
+        if constexpr (block_size() != 0) {
+            return &HeapOps<F, A>::detach;
+        } else {
+            return static_cast<void* (*)(void*) noexcept>(nullptr);
         }
+    }
+};
+
+template <typename F, Location L, typename A, typename S>
+constexpr MoveVtable<typename Signature<S>::Invoke> make_move_vtbl() noexcept {
+    static_assert(std::is_nothrow_destructible_v<F>, "F must be nothrow destructible");
+    static_assert(std::is_nothrow_move_constructible_v<F>, "F must be nothrow move constructible");
+
+    using Sig = Signature<S>;
+    using O = Ops<F, L, A>;
+
+    return {
+        Thunks<typename Sig::template Target<F>, typename Sig::Invoke>::template invoke_at<L, A>(),
+        O::destroy_or_null(),
+        O::relocate_or_null(),
+        &O::Base::swap,
+        L,
+        O::block_size(),
+        O::detach_or_null(),
+#ifdef FN2_INSTRUMENT
+        &STORAGE_COUNTERS<F>,
+#endif
     };
+}
 
-    return vtbl;
+template <typename F, Location L, typename A, typename S>
+constexpr Vtable<typename Signature<S>::Invoke> make_vtbl() noexcept {
+    static_assert(std::is_copy_constructible_v<F>, "F must be copy constructible");
+
+    return {make_move_vtbl<F, L, A, S>(), Ops<F, L, A>::copy_or_null()};
 }
 
+/**
+ *  The vtable for a move-only BasicFunction with signature S that
+ *  wraps an F stored at L and allocated by A.
+ *
+ *  Vtables are constant initialized, so taking their address never
+ *  requires a guard for thread-safe initialization.
+ */
+template <typename F, Location L, typename A, typename S>
+inline constexpr MoveVtable<typename Signature<S>::Invoke> MOVE_VTBL = make_move_vtbl<F, L, A, S>();
+
+/**
+ *  The vtable for a copyable BasicFunction with signature S that wraps
+ *  an F stored at L and allocated by A.
+ */
+template <typename F, Location L, typename A, typename S>
+inline constexpr Vtable<typename Signature<S>::Invoke> VTBL = make_vtbl<F, L, A, S>();
+
+/**
+ *  The invoke thunk pointer of a BasicFunction whose thunks have
+ *  signature S, loaded from the vtable on each call.
+ */
+template <typename S, bool IsCached>
+class InvokeCache {
+protected:
+    template <typename V>
+    static auto load_invoke(const V *vptr) noexcept {
+        return vptr->invoke;
+    }
+
+    template <typename V>
+    void store_invoke(const V*) noexcept { }
+};
+
+/**
+ *  A copy of the invoke thunk pointer of a BasicFunction whose thunks
+ *  have signature S, so that invocation does not first need to load
+ *  the vtable pointer.
+ */
+template <typename S>
+class InvokeCache<S, true> {
+protected:
+    template <typename V>
+    auto load_invoke(const V*) const noexcept {
+        return invoke_;
+    }
+
+    template <typename V>
+    void store_invoke(const V *vptr) noexcept {
+        invoke_ = vptr ? vptr->invoke : nullptr;
+    }
+
+private:
+    decltype(MoveVtable<S>::invoke) invoke_ = nullptr;
+};
+
+/**
+ *  The call operator of a BasicFunction D whose thunks have signature
+ *  S. If IsRvalue, the call operator is &&-qualified; otherwise it is
+ *  const-qualified.
+ */
+template <typename D, typename S, bool IsRvalue>
+class Invoker;
+
+template <typename D, typename R, typename ...As, bool NX>
+class Invoker<D, R(As...) noexcept(NX), false> {
+public:
+    /**
+     *  @param this must wrap an object.
+     *  @returns the result of invoking the wrapped object with
+     *           parameters (std::forward<As>(as...)).
+     *
+     *  @throws any exceptions that the wrapped object throws on
+     *          invocation.
+     */
+    R operator()(As ...as) const noexcept(NX) {
+        const D &self = static_cast<const D&>(*this);
+        assert(self.vptr_);
+
+        // the vtable's invoke thunk knows whether the object is stored
+        // in storage_ or on the free store, so no branch is needed here
+        return self.load_invoke(self.vptr_)(&self.storage_, std::forward<As>(as)...);
+    }
+};
+
+template <typename D, typename R, typename ...As, bool NX>
+class Invoker<D, R(As...) noexcept(NX), true> {
+public:
+    /**
+     *  The wrapped object is invoked as an rvalue, so it may be left
+     *  in a moved-from state.
+     *
+     *  @param this must wrap an object.
+     *  @returns the result of invoking the wrapped object with
+     *           parameters (std::forward<As>(as...)).
+     *
+     *  @throws any exceptions that the wrapped object throws on
+     *          invocation.
+     */
+    R operator()(As ...as) && noexcept(NX) {
+        D &self = static_cast<D&>(*this);
+        assert(self.vptr_);
+
+        return self.load_invoke(self.vptr_)(&self.storage_, std::forward<As>(as)...);
+    }
+};
+
+/** Gives algorithms access to the vtable pointer of a BasicFunction. */
+struct FunctionAccess {
+    template <typename F>
+    static const void* vptr(const F &f) noexcept {
+        return f.vptr_;
+    }
+};
+
+/** @returns true if t is an object in the size bytes at block. */
+template <typename T>
+bool is_within(const void *block, std::size_t size, const T &t) noexcept {
+    if constexpr (std::is_function_v<T>) {
+        return false;
+    } else {
+        const auto first = reinterpret_cast<std::uintptr_t>(block);
+        const auto address = reinterpret_cast<std::uintptr_t>(std::addressof(t));
+
+        return address >= first && address < first + size;
+    }
+}
+
+/**
+ *  True if T is a function wrapper that can be empty, such as
+ *  std::function. Specialized for BasicFunction in fn2.h.
+ */
+template <typename T>
+struct is_function_wrapper : std::false_type { };
+
+template <typename S>
+struct is_function_wrapper<std::function<S>> : std::true_type { };
+
+/** True if an object of type T can be null or empty. */
+template <typename T>
+inline constexpr bool is_nullable_v =
+    std::is_pointer_v<T> || std::is_member_pointer_v<T> || is_function_wrapper<T>::value;
+
+/**
+ *  @returns true if t is a null function, member or object pointer,
+ *           or an empty function wrapper.
+ */
+template <typename T>
+constexpr bool is_null(const T &t) noexcept {
+    if constexpr (std::is_pointer_v<T> || std::is_member_pointer_v<T>) {
+        return t == nullptr;
+    } else if constexpr (is_function_wrapper<T>::value) {
+        return !t;
+    } else {
+        return false;
+    }
+}
+
+/**
+ *  A type that cannot be constructed, used as the parameter of a
+ *  copy constructor that must not exist.
+ */
+struct NotCopyable {
+    NotCopyable() = delete;
+};
+
 } // namespace fn2::detail
 
 #endif
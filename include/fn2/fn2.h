@@ -27,15 +27,93 @@
 #include <fn2/detail.h>
 
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <initializer_list>
+#include <memory>
 #include <type_traits>
 #include <utility>
 
 namespace fn2 {
 
+/** Flags that modify the behavior of a BasicFunction. */
+enum class Flags : unsigned {
+    /** BasicFunction and its wrapped objects are copyable. */
+    None = 0,
+    /**
+     *  The wrapped object need only be movable, and the BasicFunction
+     *  is move-only.
+     */
+    MoveOnly = 1 << 0,
+    /**
+     *  The BasicFunction stores a copy of the pointer to its invoke
+     *  thunk alongside the vtable pointer, so invocation needs one
+     *  load before the indirect call instead of two dependent loads.
+     *  This makes the BasicFunction one pointer larger.
+     */
+    CacheInvoke = 1 << 1,
+    /**
+     *  Wrapped objects stored on the free store are reference counted
+     *  and shared by copies of the BasicFunction instead of being
+     *  copied, so copying one is an atomic increment. The signature
+     *  must be const-qualified, so a shared object is never modified.
+     */
+    Shared = 1 << 2,
+    /**
+     *  With Flags::Shared, the reference count is not atomic, so all
+     *  BasicFunctions that share a wrapped object must be copied and
+     *  destroyed by the same thread.
+     */
+    NonAtomic = 1 << 3,
+    /**
+     *  Wrapped objects are never stored on the free store. Constructing
+     *  the BasicFunction from an object that does not fit inline fails
+     *  to compile instead of allocating.
+     */
+    InlineOnly = 1 << 4,
+};
+
+/** @returns the union of lhs and rhs. */
+constexpr Flags operator|(Flags lhs, Flags rhs) noexcept {
+    return static_cast<Flags>(static_cast<unsigned>(lhs) | static_cast<unsigned>(rhs));
+}
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
-template <typename S>
-class Function;
+namespace detail {
+
+// a Function with the default capacity and alignment is exactly one
+// cache line: the buffer followed by the vtable pointer
+inline constexpr std::size_t CACHE_LINE_SIZE = 64;
+inline constexpr std::size_t DEFAULT_CAPACITY = CACHE_LINE_SIZE - sizeof(void*);
+inline constexpr std::size_t DEFAULT_ALIGN = alignof(void*);
+
+constexpr bool has_flag(Flags flags, Flags flag) noexcept {
+    return (static_cast<unsigned>(flags) & static_cast<unsigned>(flag)) != 0;
+}
+
+// true if an F is stored inline by a BasicFunction with the given
+// inline capacity and alignment
+template <typename F, std::size_t Capacity, std::size_t Align>
+constexpr bool fits_inline() noexcept {
+    using Storage = std::aligned_storage_t<Capacity, Align>;
+
+    return sizeof(F) <= sizeof(Storage) && alignof(Storage) % alignof(F) == 0;
+}
+
+} // namespace detail
+
+template <typename S,
+          std::size_t Capacity = detail::DEFAULT_CAPACITY,
+          std::size_t Align = detail::DEFAULT_ALIGN,
+          Flags Fs = Flags::None>
+class BasicFunction;
+
+namespace detail {
+
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+struct is_function_wrapper<BasicFunction<S, Capacity, Align, Fs>> : std::true_type { };
+
+} // namespace detail
 #endif
 
 /**
@@ -54,27 +132,103 @@ class Function;
  *  If the wrapped object is small enough and has a suitable alignment,
  *  it will be stored inside the Function object without dynamic
  *  allocation. Otherwise, the wrapped object will be stored on the
- *  free store and handled via operator new()/operator delete().
+ *  free store, allocated by the allocator passed to the constructor or
+ *  by a SlabAllocator if none was.
+ *
+ *  @tparam S the signature of this BasicFunction, a function type
+ *          R(As...) that may be qualified with const or && and may be
+ *          noexcept. If S is const-qualified, the wrapped object is
+ *          invoked as a const lvalue and so must be const-invocable;
+ *          otherwise it is invoked as a non-const lvalue, even though
+ *          operator() is a const member function. If S is
+ *          &&-qualified, operator() is &&-qualified and invokes the
+ *          wrapped object as an rvalue. If S is noexcept, operator()
+ *          is noexcept and the wrapped object must be nothrow
+ *          invocable.
+ *  @tparam Capacity the size, in bytes, of the inline storage. Wrapped
+ *          objects no larger than Capacity are stored inline. By
+ *          default, a BasicFunction is exactly 64 bytes, one cache
+ *          line, of which all but one pointer is inline storage.
+ *  @tparam Align the alignment, in bytes, of the inline storage.
+ *          Wrapped objects whose alignment evenly divides Align are
+ *          stored inline. Must be a power of two. By default, the
+ *          alignment of a pointer.
+ *  @tparam Fs modify the behavior of this BasicFunction. If
+ *          Flags::MoveOnly is set, wrapped objects need not be
+ *          copyable and this BasicFunction cannot be copied. If
+ *          Flags::CacheInvoke is set, this BasicFunction stores the
+ *          pointer to its invoke thunk as well as its vtable pointer.
+ *          Reduce Capacity by the size of a pointer to keep it to one
+ *          cache line. If Flags::Shared is set, copies of this
+ *          BasicFunction share wrapped objects stored on the free
+ *          store; see BasicSharedFunction. If Flags::InlineOnly is
+ *          set, wrapped objects that do not fit inline are rejected at
+ *          compile time; see BasicInlineOnlyFunction.
  */
-template <typename R, typename ...As>
-class Function<R(As...)> {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+class BasicFunction
+: public detail::Invoker<
+      BasicFunction<S, Capacity, Align, Fs>,
+      typename detail::Signature<S>::Invoke,
+      detail::Signature<S>::IS_RVALUE
+  >,
+  detail::InvokeCache<typename detail::Signature<S>::Invoke, detail::has_flag(Fs, Flags::CacheInvoke)> {
+    static_assert(Capacity >= sizeof(void*), "Capacity must be large enough to hold a pointer");
+    static_assert(Align >= alignof(void*), "Align must be at least the alignment of a pointer");
+    static_assert((Align & (Align - 1)) == 0, "Align must be a power of two");
+    static_assert(
+        !detail::has_flag(Fs, Flags::Shared) || detail::Signature<S>::IS_CONST,
+        "Flags::Shared requires a const-qualified signature"
+    );
+    static_assert(
+        !detail::has_flag(Fs, Flags::Shared) || !detail::has_flag(Fs, Flags::MoveOnly),
+        "Flags::Shared and Flags::MoveOnly are mutually exclusive"
+    );
+    static_assert(
+        !detail::has_flag(Fs, Flags::NonAtomic) || detail::has_flag(Fs, Flags::Shared),
+        "Flags::NonAtomic requires Flags::Shared"
+    );
+
+    static constexpr bool IS_COPYABLE = !detail::has_flag(Fs, Flags::MoveOnly);
+
+    // where wrapped objects that do not fit in storage_ are stored
+    static constexpr detail::Location HEAP_LOCATION =
+        !detail::has_flag(Fs, Flags::Shared) ? detail::Location::Heap
+        : detail::has_flag(Fs, Flags::NonAtomic) ? detail::Location::LocalShared
+        : detail::Location::Shared;
+
+    // when this BasicFunction is move-only, the copy constructor and
+    // copy assignment operator take a type that cannot be constructed
+    // so that the implicitly declared ones are deleted
+    using CopySource = std::conditional_t<
+        IS_COPYABLE, const BasicFunction&, const detail::NotCopyable&
+    >;
+    using Invoke = typename detail::Signature<S>::Invoke;
+    using VtableType = std::conditional_t<
+        IS_COPYABLE, detail::Vtable<Invoke>, detail::MoveVtable<Invoke>
+    >;
+
 public:
     /** @returns a Function that does not wrap any object. */
-    inline Function() noexcept;
+    inline BasicFunction() noexcept;
+
+    /** @returns a Function that does not wrap any object. */
+    inline BasicFunction(std::nullptr_t) noexcept;
 
     /**
      *  @tparam std::decay_t<F> must not be an object of type Function.
      *          Must be constructible from (F).
      *  @returns a Function that wraps an object of type
      *           std::decay_t<F>, direct initialized from
-     *           (std::forward<F>(f)).
+     *           (std::forward<F>(f)), or no object if f is a null
+     *           pointer or an empty function wrapper.
      *
      *  @throws std::bad_alloc
      *  @throws any exceptions that the constructor of std::decay_t<F>
      *          throws.
      */
-    template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, Function>, int> = 0>
-    inline Function(F &&f);
+    template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, BasicFunction>, int> = 0>
+    inline BasicFunction(F &&f);
 
     /**
      *  @tparam std::decay_t<F> must be default constructible.
@@ -86,7 +240,7 @@ public:
      *          std::decay_t<F> throws.
      */
     template <typename F>
-    inline explicit Function(std::in_place_type_t<F>);
+    inline explicit BasicFunction(std::in_place_type_t<F>);
 
     /**
      *  @tparam std::decay_t<F> Must be constructible from (U, Us...).
@@ -99,7 +253,7 @@ public:
      *          throws.
      */
     template <typename F, typename U, typename ...Us>
-    inline Function(std::in_place_type_t<F>, U &&u, Us &&...us);
+    inline BasicFunction(std::in_place_type_t<F>, U &&u, Us &&...us);
 
     /**
      *  @tparam std::decay_t<F> Must be constructible from
@@ -113,7 +267,51 @@ public:
      *          throws.
      */
     template <typename F, typename U, typename ...Us>
-    inline Function(std::in_place_type_t<F>, std::initializer_list<U> list, Us &&...us);
+    inline BasicFunction(std::in_place_type_t<F>, std::initializer_list<U> list, Us &&...us);
+
+    /**
+     *  If the wrapped object is stored on the free store, it is
+     *  allocated by a copy of alloc rebound to an unspecified type.
+     *  Copies of this Function allocate their wrapped object in the
+     *  same way.
+     *
+     *  @tparam A must satisfy the Allocator requirements, or be
+     *          convertible to std::pmr::memory_resource*, in which case
+     *          a std::pmr::polymorphic_allocator is used.
+     *  @tparam std::decay_t<F> must not be an object of type Function.
+     *          Must be constructible from (F).
+     *  @returns a Function that wraps an object of type
+     *           std::decay_t<F>, direct initialized from
+     *           (std::forward<F>(f)), or no object if f is a null
+     *           pointer or an empty function wrapper.
+     *
+     *  @throws any exceptions that alloc throws on allocation.
+     *  @throws any exceptions that the constructor of std::decay_t<F>
+     *          throws.
+     */
+    template <typename A, typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, BasicFunction>, int> = 0>
+    inline BasicFunction(std::allocator_arg_t, const A &alloc, F &&f);
+
+    /**
+     *  If the wrapped object is stored on the free store, it is
+     *  allocated by a copy of alloc rebound to an unspecified type.
+     *  Copies of this Function allocate their wrapped object in the
+     *  same way.
+     *
+     *  @tparam A must satisfy the Allocator requirements, or be
+     *          convertible to std::pmr::memory_resource*, in which case
+     *          a std::pmr::polymorphic_allocator is used.
+     *  @tparam std::decay_t<F> Must be constructible from (Us...).
+     *  @returns a Function that wraps an object of type
+     *           std::decay_t<F>, direct initialized from
+     *           (std::forward<Us>(us)...).
+     *
+     *  @throws any exceptions that alloc throws on allocation.
+     *  @throws any exceptions that the constructor of std::decay_t<F>
+     *          throws.
+     */
+    template <typename A, typename F, typename ...Us>
+    inline BasicFunction(std::allocator_arg_t, const A &alloc, std::in_place_type_t<F>, Us &&...us);
 
     /**
      *  @returns a Function that wraps an object copied from other's
@@ -123,16 +321,16 @@ public:
      *  @throws any exceptions that the copy constructor of other's
      *          wrapped object throws.
      */
-    inline Function(const Function &other);
+    inline BasicFunction(CopySource other);
 
     /**
      *  @param other will no longer wrap an object.
      *  @returns a Function that wraps the object that other wrapped.
      */
-    inline Function(Function &&other) noexcept;
+    inline BasicFunction(BasicFunction &&other) noexcept;
 
     /** Deallocates and destroys any wrapped object. */
-    inline ~Function();
+    inline ~BasicFunction();
 
     /**
      *  @returns this Function, which now wraps an object copied from
@@ -142,7 +340,7 @@ public:
      *  @throws any exceptions that the copy constructor of other's
      *          wrapped object throws.
      */
-    inline Function& operator=(const Function &other);
+    inline BasicFunction& operator=(CopySource other);
 
     /**
      *  Swaps ownership of this Function's wrapped object with other.
@@ -151,27 +349,41 @@ public:
      *  @returns this Function, which now that wraps the object that
      *           other wrapped.
      */
-    inline Function& operator=(Function &&other) noexcept;
+    inline BasicFunction& operator=(BasicFunction &&other) noexcept;
+
+    /**
+     *  Deallocates and destroys any wrapped object.
+     *
+     *  @returns this Function, which no longer wraps an object.
+     */
+    inline BasicFunction& operator=(std::nullptr_t) noexcept;
 
     /**
      *  If an exception is thrown, this Function will remain unchanged.
      *
+     *  If this Function's wrapped object is on the free store in a
+     *  block that also fits the new wrapped object, and constructing
+     *  the new wrapped object cannot throw, the block is reused.
+     *
      *  @tparam std::decay_t<F> must not be an object of type Function.
      *          Must be constructible from (F).
      *  @returns this Function, which now wraps an object of type
      *           std::decay_t<F> direct initialized from
-     *           (std::forward<F>(f)).
+     *           (std::forward<F>(f)), or no object if f is a null
+     *           pointer or an empty function wrapper.
      *
      *  @throws std::bad_alloc
      *  @throws any exceptions that the constructor of std::decay_t<F>
      *          throws.
      */
-    template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, Function>, int> = 0>
-    inline Function& operator=(F &&f);
+    template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, BasicFunction>, int> = 0>
+    inline BasicFunction& operator=(F &&f);
 
     /**
      *  Constructs a new wrapped object of type std::decay_t<F>,
-     *  direct initialized from (std::forward<Us>(us)...).
+     *  direct initialized from (std::forward<Us>(us)...). Reuses the
+     *  block of a wrapped object on the free store in the same way as
+     *  operator=(F&&).
      *
      *  @tparam std::decay_t<F> must be constructible from (Us...).
      *
@@ -184,7 +396,9 @@ public:
 
     /**
      *  Constructs a new wrapped object of type std::decay_t<F>,
-     *  direct initialized from (list, std::forward<Us>(us)...).
+     *  direct initialized from (list, std::forward<Us>(us)...). Reuses
+     *  the block of a wrapped object on the free store in the same way
+     *  as operator=(F&&).
      *
      *  @tparam std::decay_t<F> must be constructible from
      *          (std::initializer_list<U>&, Us...).
@@ -203,58 +417,188 @@ public:
     inline void reset() noexcept;
 
     /** Swaps ownership of wrapped objects with another Function. */
-    inline void swap(Function &other) noexcept;
-
-    /**
-     *  @param this must wrap an object.
-     *  @returns the result of invoking the wrapped object with
-     *           parameters (std::forward<As>(as...)).
-     *
-     *  @throws any exceptions that the wrapped object throws on
-     *          invocation.
-     */
-    inline R operator()(As ...as) const;
+    inline void swap(BasicFunction &other) noexcept;
 
     /** @returns true if this Function currently wraps an object. */
     inline explicit operator bool() const noexcept;
 
+    /**
+     *  @returns true if this Function wraps an object that is stored
+     *           inline rather than on the free store.
+     */
+    inline bool is_inline() const noexcept;
+
 private:
-    using Storage = std::aligned_storage_t<16 * sizeof(float) - sizeof(bool) - sizeof(void*)>;
+    template <typename, typename, bool>
+    friend class detail::Invoker;
+
+    friend struct detail::FunctionAccess;
+
+    using Storage = std::aligned_storage_t<Capacity, Align>;
 
     template <typename F, typename ...Ts>
     inline void construct(Ts &&...ts);
 
-    inline void*& as_ptr() noexcept;
+    template <typename F, typename A, typename ...Ts>
+    inline void construct_alloc(const A &alloc, Ts &&...ts);
+
+    // if constructing a std::decay_t<F> from (ts...) cannot throw,
+    // replaces the wrapped object with one constructed from (ts...)
+    // without a temporary BasicFunction: directly in storage_ if it
+    // fits inline, or else in the wrapped object's block on the free
+    // store, if it is from the default allocator and fits
+    template <typename F, typename ...Ts>
+    inline bool try_replace(Ts &&...ts) noexcept;
+
+    template <typename F, detail::Location L, typename A>
+    inline static constexpr const VtableType& get_vtbl() noexcept;
+
+    inline bool is_trivially_relocatable() const noexcept;
 
-    inline void* as_ptr() const noexcept;
+    // this BasicFunction must not wrap an object; other will no longer
+    // wrap an object
+    inline void relocate_from(BasicFunction &other) noexcept;
 
     mutable Storage storage_;
-    bool is_ptr_;
-    const detail::Vtable<R, As...> *vptr_ = nullptr;
+    const VtableType *vptr_ = nullptr;
 };
 
+/**
+ *  Function is a BasicFunction with the default inline capacity and
+ *  alignment.
+ */
+template <typename S>
+using Function = BasicFunction<S>;
+
+/**
+ *  BasicUniqueFunction is a move-only BasicFunction that can wrap
+ *  move-only objects, such as lambda expressions that capture a
+ *  std::unique_ptr or std::promise.
+ */
+template <typename S,
+          std::size_t Capacity = detail::DEFAULT_CAPACITY,
+          std::size_t Align = detail::DEFAULT_ALIGN>
+using BasicUniqueFunction = BasicFunction<S, Capacity, Align, Flags::MoveOnly>;
+
+/**
+ *  UniqueFunction is a BasicUniqueFunction with the default inline
+ *  capacity and alignment.
+ */
+template <typename S>
+using UniqueFunction = BasicUniqueFunction<S>;
+
+/**
+ *  BasicSharedFunction is a BasicFunction whose copies share wrapped
+ *  objects that are stored on the free store, so copying one
+ *  increments a reference count instead of copying the wrapped object.
+ *  Wrapped objects stored inline are still copied.
+ *
+ *  S must be const-qualified. If IsAtomic is false, the reference
+ *  count is not atomic and all BasicSharedFunctions that share a
+ *  wrapped object must be copied and destroyed by the same thread.
+ */
+template <typename S,
+          std::size_t Capacity = detail::DEFAULT_CAPACITY,
+          std::size_t Align = detail::DEFAULT_ALIGN,
+          bool IsAtomic = true>
+using BasicSharedFunction = BasicFunction<
+    S, Capacity, Align, IsAtomic ? Flags::Shared : Flags::Shared | Flags::NonAtomic
+>;
+
+/**
+ *  SharedFunction is a BasicSharedFunction with the default inline
+ *  capacity and alignment and an atomic reference count.
+ */
+template <typename S>
+using SharedFunction = BasicSharedFunction<S>;
+
+/**
+ *  LocalSharedFunction is a BasicSharedFunction with the default inline
+ *  capacity and alignment and a reference count that is not atomic,
+ *  for use by a single thread.
+ */
+template <typename S>
+using LocalSharedFunction = BasicSharedFunction<S, detail::DEFAULT_CAPACITY, detail::DEFAULT_ALIGN, false>;
+
+/**
+ *  BasicInlineOnlyFunction is a BasicFunction that never allocates.
+ *  Wrapping an object that does not fit in Capacity bytes with an
+ *  alignment that divides Align fails to compile.
+ */
+template <typename S,
+          std::size_t Capacity = detail::DEFAULT_CAPACITY,
+          std::size_t Align = detail::DEFAULT_ALIGN>
+using BasicInlineOnlyFunction = BasicFunction<S, Capacity, Align, Flags::InlineOnly>;
+
+/**
+ *  InlineOnlyFunction is a BasicInlineOnlyFunction with the default
+ *  inline capacity and alignment.
+ */
+template <typename S>
+using InlineOnlyFunction = BasicInlineOnlyFunction<S>;
+
+/**
+ *  fits_inline is true if a BasicFunction of type Fn stores a wrapped
+ *  object of type std::decay_t<F> inline, without allocating.
+ */
+template <typename Fn, typename F>
+struct fits_inline;
+
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs, typename F>
+struct fits_inline<BasicFunction<S, Capacity, Align, Fs>, F>
+: std::bool_constant<detail::fits_inline<std::decay_t<F>, Capacity, Align>()> { };
+
+template <typename Fn, typename F>
+inline constexpr bool fits_inline_v = fits_inline<Fn, F>::value;
+
 /** Swaps ownership of two Function's wrapped objects. */
-template <typename R, typename ...As>
-inline void swap(Function<R(As...)> &lhs, Function<R(As...)> &rhs) noexcept;
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+inline void swap(BasicFunction<S, Capacity, Align, Fs> &lhs,
+                 BasicFunction<S, Capacity, Align, Fs> &rhs) noexcept;
+
+/** @returns true if f does not wrap an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+inline bool operator==(const BasicFunction<S, Capacity, Align, Fs> &f, std::nullptr_t) noexcept;
+
+/** @returns true if f does not wrap an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+inline bool operator==(std::nullptr_t, const BasicFunction<S, Capacity, Align, Fs> &f) noexcept;
+
+/** @returns true if f wraps an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+inline bool operator!=(const BasicFunction<S, Capacity, Align, Fs> &f, std::nullptr_t) noexcept;
+
+/** @returns true if f wraps an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+inline bool operator!=(std::nullptr_t, const BasicFunction<S, Capacity, Align, Fs> &f) noexcept;
+
+/** @returns a Function that does not wrap any object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction() noexcept { }
 
 /** @returns a Function that does not wrap any object. */
-template <typename R, typename ...As>
-Function<R(As...)>::Function() noexcept { }
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(std::nullptr_t) noexcept { }
 
 /**
  *  @tparam std::decay_t<F> must not be an object of type Function.
  *          Must be constructible from (F).
  *  @returns a Function that wraps an object of type
  *           std::decay_t<F>, direct initialized from
- *           (std::forward<F>(f)).
+ *           (std::forward<F>(f)), or no object if f is a null
+ *           pointer or an empty function wrapper.
  *
  *  @throws std::bad_alloc
  *  @throws any exceptions that the constructor of std::decay_t<F>
  *          throws.
  */
-template <typename R, typename ...As>
-template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, Function<R(As...)>>, int>>
-Function<R(As...)>::Function(F &&f) {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, BasicFunction<S, Capacity, Align, Fs>>, int>>
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(F &&f) {
+    if (detail::is_null<std::decay_t<F>>(f)) {
+        return;
+    }
+
     construct<F>(std::forward<F>(f));
 }
 
@@ -267,9 +611,9 @@ Function<R(As...)>::Function(F &&f) {
  *  @throws aany exceptions that the default constructor of
  *          std::decay_t<F> throws.
  */
-template <typename R, typename ...As>
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
 template <typename F>
-Function<R(As...)>::Function(std::in_place_type_t<F>) {
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(std::in_place_type_t<F>) {
     construct<F>();
 }
 
@@ -283,9 +627,9 @@ Function<R(As...)>::Function(std::in_place_type_t<F>) {
  *  @throws any exceptions that the constructor of std::decay_t<F>
  *          throws.
  */
-template <typename R, typename ...As>
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
 template <typename F, typename U, typename ...Us>
-Function<R(As...)>::Function(std::in_place_type_t<F>, U &&u, Us &&...us) {
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(std::in_place_type_t<F>, U &&u, Us &&...us) {
     construct<F>(std::forward<U>(u), std::forward<Us>(us)...);
 }
 
@@ -300,12 +644,65 @@ Function<R(As...)>::Function(std::in_place_type_t<F>, U &&u, Us &&...us) {
  *  @throws any exceptions that the constructor of std::decay_t<F>
  *          throws.
  */
-template <typename R, typename ...As>
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
 template <typename F, typename U, typename ...Us>
-Function<R(As...)>::Function(std::in_place_type_t<F>, std::initializer_list<U> list, Us &&...us) {
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(std::in_place_type_t<F>, std::initializer_list<U> list, Us &&...us) {
     construct<F>(list, std::forward<Us>(us)...);
 }
 
+/**
+ *  If the wrapped object is stored on the free store, it is allocated
+ *  by a copy of alloc rebound to an unspecified type. Copies of this
+ *  Function allocate their wrapped object in the same way.
+ *
+ *  @tparam A must satisfy the Allocator requirements, or be
+ *          convertible to std::pmr::memory_resource*, in which case a
+ *          std::pmr::polymorphic_allocator is used.
+ *  @tparam std::decay_t<F> must not be an object of type Function.
+ *          Must be constructible from (F).
+ *  @returns a Function that wraps an object of type std::decay_t<F>,
+ *           direct initialized from (std::forward<F>(f)), or no
+ *           object if f is a null pointer or an empty function
+ *           wrapper.
+ *
+ *  @throws any exceptions that alloc throws on allocation.
+ *  @throws any exceptions that the constructor of std::decay_t<F>
+ *          throws.
+ */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+template <typename A, typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, BasicFunction<S, Capacity, Align, Fs>>, int>>
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(std::allocator_arg_t, const A &alloc, F &&f) {
+    if (detail::is_null<std::decay_t<F>>(f)) {
+        return;
+    }
+
+    construct_alloc<F>(detail::to_byte_allocator(alloc), std::forward<F>(f));
+}
+
+/**
+ *  If the wrapped object is stored on the free store, it is allocated
+ *  by a copy of alloc rebound to an unspecified type. Copies of this
+ *  Function allocate their wrapped object in the same way.
+ *
+ *  @tparam A must satisfy the Allocator requirements, or be
+ *          convertible to std::pmr::memory_resource*, in which case a
+ *          std::pmr::polymorphic_allocator is used.
+ *  @tparam std::decay_t<F> Must be constructible from (Us...).
+ *  @returns a Function that wraps an object of type std::decay_t<F>,
+ *           direct initialized from (std::forward<Us>(us)...).
+ *
+ *  @throws any exceptions that alloc throws on allocation.
+ *  @throws any exceptions that the constructor of std::decay_t<F>
+ *          throws.
+ */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+template <typename A, typename F, typename ...Us>
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(
+    std::allocator_arg_t, const A &alloc, std::in_place_type_t<F>, Us &&...us
+) {
+    construct_alloc<F>(detail::to_byte_allocator(alloc), std::forward<Us>(us)...);
+}
+
 /**
  *  @returns this Function, which now wraps an object copied from
  *           other's wrapped object.
@@ -314,44 +711,35 @@ Function<R(As...)>::Function(std::in_place_type_t<F>, std::initializer_list<U> l
  *  @throws any exceptions that the copy constructor of other's
  *          wrapped object throws.
  */
-template <typename R, typename ...As>
-Function<R(As...)>::Function(const Function &other) : vptr_(other.vptr_) {
-    if (!vptr_) {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(CopySource other) {
+    if (!other.vptr_) {
         return;
     }
 
-    is_ptr_ = other.is_ptr_;
-
-    if (is_ptr_) {
-        as_ptr() = vptr_->clone(other.as_ptr());
+    if (other.vptr_->copy) {
+        other.vptr_->copy(&storage_, &other.storage_);
     } else {
-        vptr_->copy(&storage_, &other.storage_);
+        std::memcpy(&storage_, &other.storage_, sizeof(Storage));
     }
+
+    vptr_ = other.vptr_;
+    this->store_invoke(vptr_);
+    detail::count_storage(vptr_, &detail::StorageCounters::clones);
 }
 
 /**
  *  @param other will no longer wrap an object.
  *  @returns a Function that wraps the object that other wrapped.
  */
-template <typename R, typename ...As>
-Function<R(As...)>::Function(Function &&other) noexcept : vptr_(other.vptr_) {
-    if (!vptr_) {
-        return;
-    }
-
-    is_ptr_ = other.is_ptr_;
-
-    if (is_ptr_) {
-        as_ptr() = other.as_ptr();
-        other.vptr_ = nullptr;
-    } else {
-        vptr_->move(&storage_, &other.storage_);
-    }
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>::BasicFunction(BasicFunction &&other) noexcept {
+    relocate_from(other);
 }
 
 /** Deallocates and destroys any wrapped object. */
-template <typename R, typename ...As>
-Function<R(As...)>::~Function() {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>::~BasicFunction() {
     reset();
 }
 
@@ -363,10 +751,10 @@ Function<R(As...)>::~Function() {
  *  @throws any exceptions that the copy constructor of other's
  *          wrapped object throws.
  */
-template <typename R, typename ...As>
-Function<R(As...)>& Function<R(As...)>::operator=(const Function &other) {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>& BasicFunction<S, Capacity, Align, Fs>::operator=(CopySource other) {
     if (this != &other) {
-        Function copy(other);
+        BasicFunction copy(other);
         swap(copy);
     }
 
@@ -380,8 +768,8 @@ Function<R(As...)>& Function<R(As...)>::operator=(const Function &other) {
  *  @returns this Function, which now that wraps the object that
  *           other wrapped.
  */
-template <typename R, typename ...As>
-Function<R(As...)>& Function<R(As...)>::operator=(Function &&other) noexcept {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>& BasicFunction<S, Capacity, Align, Fs>::operator=(BasicFunction &&other) noexcept {
     if (this != &other) {
         swap(other);
     }
@@ -389,31 +777,54 @@ Function<R(As...)>& Function<R(As...)>::operator=(Function &&other) noexcept {
     return *this;
 }
 
+/**
+ *  Deallocates and destroys any wrapped object.
+ *
+ *  @returns this Function, which no longer wraps an object.
+ */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>& BasicFunction<S, Capacity, Align, Fs>::operator=(std::nullptr_t) noexcept {
+    reset();
+
+    return *this;
+}
+
 /**
  *  If an exception is thrown, this Function will remain unchanged.
  *
+ *  If this Function's wrapped object is on the free store in a block
+ *  that also fits the new wrapped object, and constructing the new
+ *  wrapped object cannot throw, the block is reused.
+ *
  *  @tparam std::decay_t<F> must not be an object of type Function.
  *          Must be constructible from (F).
  *  @returns this Function, which now wraps an object of type
  *           std::decay_t<F> direct initialized from
- *           (std::forward<F>(f)).
+ *           (std::forward<F>(f)), or no object if f is a null
+ *           pointer or an empty function wrapper.
  *
  *  @throws std::bad_alloc
  *  @throws any exceptions that the constructor of std::decay_t<F>
  *          throws.
  */
-template <typename R, typename ...As>
-template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, Function<R(As...)>>, int>>
-Function<R(As...)>& Function<R(As...)>::operator=(F &&f) {
-    Function new_func = std::forward<F>(f);
-    swap(new_func);
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, BasicFunction<S, Capacity, Align, Fs>>, int>>
+BasicFunction<S, Capacity, Align, Fs>& BasicFunction<S, Capacity, Align, Fs>::operator=(F &&f) {
+    if (detail::is_null<std::decay_t<F>>(f)) {
+        reset();
+    } else if (!try_replace<F>(std::forward<F>(f))) {
+        BasicFunction new_func = std::forward<F>(f);
+        swap(new_func);
+    }
 
     return *this;
 }
 
 /**
  *  Constructs a new wrapped object of type std::decay_t<F>,
- *  direct initialized from (std::forward<Us>(us)...).
+ *  direct initialized from (std::forward<Us>(us)...). Reuses the
+ *  block of a wrapped object on the free store in the same way as
+ *  operator=(F&&).
  *
  *  @tparam std::decay_t<F> must be constructible from (Us...).
  *
@@ -421,16 +832,20 @@ Function<R(As...)>& Function<R(As...)>::operator=(F &&f) {
  *  @throws any exceptions that the constructor of std::decay_t<F>
  *          throws.
  */
-template <typename R, typename ...As>
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
 template <typename F, typename ...Us>
-void Function<R(As...)>::emplace(Us &&...us) {
-    Function g(std::in_place_type<F>, std::forward<Us>(us)...);
-    swap(g);
+void BasicFunction<S, Capacity, Align, Fs>::emplace(Us &&...us) {
+    if (!try_replace<F>(std::forward<Us>(us)...)) {
+        BasicFunction g(std::in_place_type<F>, std::forward<Us>(us)...);
+        swap(g);
+    }
 }
 
 /**
  *  Constructs a new wrapped object of type std::decay_t<F>,
- *  direct initialized from (list, std::forward<Us>(us)...).
+ *  direct initialized from (list, std::forward<Us>(us)...). Reuses
+ *  the block of a wrapped object on the free store in the same way
+ *  as operator=(F&&).
  *
  *  @tparam std::decay_t<F> must be constructible from
  *          (std::initializer_list<U>&, Us...).
@@ -439,26 +854,26 @@ void Function<R(As...)>::emplace(Us &&...us) {
  *  @throws any exceptions that the constructor of std::decay_t<F>
  *          throws.
  */
-template <typename R, typename ...As>
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
 template <typename F, typename U, typename ...Us>
-void Function<R(As...)>::emplace(std::initializer_list<U> list, Us &&...us) {
-    Function g(std::in_place_type<F>, list, std::forward<Us>(us)...);
-    swap(g);
+void BasicFunction<S, Capacity, Align, Fs>::emplace(std::initializer_list<U> list, Us &&...us) {
+    if (!try_replace<F>(list, std::forward<Us>(us)...)) {
+        BasicFunction g(std::in_place_type<F>, list, std::forward<Us>(us)...);
+        swap(g);
+    }
 }
 
 /**
  *  Deallocates and destroys this Function's wrapped object, if
  *  there is one.
  */
-template <typename R, typename ...As>
-void Function<R(As...)>::reset() noexcept {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+void BasicFunction<S, Capacity, Align, Fs>::reset() noexcept {
     if (!vptr_) {
         return;
     }
 
-    if (is_ptr_) {
-        vptr_->destroy_dealloc(as_ptr());
-    } else {
+    if (vptr_->destroy) {
         vptr_->destroy(&storage_);
     }
 
@@ -466,109 +881,89 @@ void Function<R(As...)>::reset() noexcept {
 }
 
 /** Swaps ownership of wrapped objects with another Function. */
-template <typename R, typename ...As>
-void Function<R(As...)>::swap(Function &other) noexcept {
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+void BasicFunction<S, Capacity, Align, Fs>::swap(BasicFunction &other) noexcept {
     if (this == &other || (!vptr_ && !other.vptr_)) {
         return;
     }
 
-    if (vptr_ == other.vptr_ && !is_ptr_ && !other.is_ptr_) {
+    if (is_trivially_relocatable() && other.is_trivially_relocatable()) {
+        Storage temp;
+        std::memcpy(&temp, &storage_, sizeof(Storage));
+        std::memcpy(&storage_, &other.storage_, sizeof(Storage));
+        std::memcpy(&other.storage_, &temp, sizeof(Storage));
+
+        std::swap(vptr_, other.vptr_);
+        this->store_invoke(vptr_);
+        other.store_invoke(other.vptr_);
+        detail::count_storage(vptr_, &detail::StorageCounters::moves);
+        detail::count_storage(other.vptr_, &detail::StorageCounters::moves);
+    } else if (vptr_ == other.vptr_) {
         vptr_->swap(&storage_, &other.storage_);
-    } else if (!vptr_) {
-        is_ptr_ = other.is_ptr_;
-
-        if (is_ptr_) {
-            as_ptr() = other.as_ptr();
-        } else {
-            other.vptr_->move(&storage_, &other.storage_);
-            other.vptr_->destroy(&other.storage_);
-        }
-    } else if (!other.vptr_) {
-        other.is_ptr_ = is_ptr_;
-
-        if (is_ptr_) {
-            other.as_ptr() = as_ptr();
-        } else {
-            vptr_->move(&other.storage_, &storage_);
-            vptr_->destroy(&storage_);
-        }
-    } else if (is_ptr_) {
-        if (other.is_ptr_) {
-            std::swap(as_ptr(), other.as_ptr());
-        } else {
-            Storage temp;
-            other.vptr_->move(&temp, &other.storage_);
-            other.vptr_->destroy(&other.storage_);
-
-            other.is_ptr_ = true;
-            other.as_ptr() = as_ptr();
-
-            is_ptr_ = false;
-            other.vptr_->move(&storage_, &temp);
-            other.vptr_->destroy(&temp);
-        }
+        detail::count_storage(vptr_, &detail::StorageCounters::moves);
+        detail::count_storage(vptr_, &detail::StorageCounters::moves);
     } else {
-        if (other.is_ptr_) {
-            Storage temp;
-            vptr_->move(&temp, &storage_);
-            vptr_->destroy(&storage_);
-
-            is_ptr_ = true;
-            as_ptr() = other.as_ptr();
-
-            other.is_ptr_ = false;
-            vptr_->move(&other.storage_, &temp);
-            vptr_->destroy(&temp);
-        } else {
-            Storage temp;
-            vptr_->move(&temp, &storage_);
-            vptr_->destroy(&storage_);
-
-            other.vptr_->move(&storage_, &other.storage_);
-            other.vptr_->destroy(&other.storage_);
-
-            vptr_->move(&other.storage_, &temp);
-            vptr_->destroy(&temp);
-        }
+        BasicFunction temp(std::move(other));
+        other.relocate_from(*this);
+        relocate_from(temp);
     }
+}
 
-    std::swap(vptr_, other.vptr_);
+/** @returns true if this Function currently wraps an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+BasicFunction<S, Capacity, Align, Fs>::operator bool() const noexcept {
+    return vptr_ != nullptr;
 }
 
 /**
- *  @param this must wrap an object.
- *  @returns the result of invoking the wrapped object with
- *           parameters (std::forward<As>(as...)).
- *
- *  @throws any exceptions that the wrapped object throws on
- *          invocation.
+ *  @returns true if this Function wraps an object that is stored
+ *           inline rather than on the free store.
  */
-template <typename R, typename ...As>
-R Function<R(As...)>::operator()(As ...as) const {
-    assert(vptr_);
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+bool BasicFunction<S, Capacity, Align, Fs>::is_inline() const noexcept {
+    return vptr_ && vptr_->location == detail::Location::Inline;
+}
 
-    if (is_ptr_) {
-        return vptr_->invoke(as_ptr(), std::forward<As>(as)...);
-    } else {
-        return vptr_->invoke(&storage_, std::forward<As>(as)...);
-    }
+/** Swaps ownership of two Function's wrapped objects. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+void swap(BasicFunction<S, Capacity, Align, Fs> &lhs,
+                 BasicFunction<S, Capacity, Align, Fs> &rhs) noexcept {
+    lhs.swap(rhs);
 }
 
-/** @returns true if this Function currently wraps an object. */
-template <typename R, typename ...As>
-Function<R(As...)>::operator bool() const noexcept {
-    return vptr_ != nullptr;
+/** @returns true if f does not wrap an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+bool operator==(const BasicFunction<S, Capacity, Align, Fs> &f, std::nullptr_t) noexcept {
+    return !f;
 }
 
-/** Swaps ownership of two Function's wrapped objects. */
-template <typename R, typename ...As>
-void swap(Function<R(As...)> &lhs, Function<R(As...)> &rhs) noexcept {
-    lhs.swap(rhs);
+/** @returns true if f does not wrap an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+bool operator==(std::nullptr_t, const BasicFunction<S, Capacity, Align, Fs> &f) noexcept {
+    return !f;
+}
+
+/** @returns true if f wraps an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+bool operator!=(const BasicFunction<S, Capacity, Align, Fs> &f, std::nullptr_t) noexcept {
+    return static_cast<bool>(f);
 }
 
-template <typename R, typename ...As>
+/** @returns true if f wraps an object. */
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+bool operator!=(std::nullptr_t, const BasicFunction<S, Capacity, Align, Fs> &f) noexcept {
+    return static_cast<bool>(f);
+}
+
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
 template <typename F, typename ...Ts>
-void Function<R(As...)>::construct(Ts &&...ts) {
+void BasicFunction<S, Capacity, Align, Fs>::construct(Ts &&...ts) {
+    construct_alloc<F>(detail::DefaultAllocator(), std::forward<Ts>(ts)...);
+}
+
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+template <typename F, typename A, typename ...Ts>
+void BasicFunction<S, Capacity, Align, Fs>::construct_alloc(const A &alloc, Ts &&...ts) {
     static_assert(
         std::is_constructible_v<std::decay_t<F>, Ts...>,
         "std::decay_t<F> must be constructible from (Ts...)"
@@ -578,31 +973,134 @@ void Function<R(As...)>::construct(Ts &&...ts) {
 
     assert(!vptr_);
 
-    vptr_ = &detail::get_vtbl<Obj, R, As...>();
+    if constexpr (detail::fits_inline<Obj, Capacity, Align>()) {
+        new (&storage_) Obj(std::forward<Ts>(ts)...);
+        vptr_ = &get_vtbl<Obj, detail::Location::Inline, detail::DefaultAllocator>();
+        this->store_invoke(vptr_);
+        detail::count_storage<Obj>(&detail::StorageCounters::inline_constructions);
+    } else {
+        static_assert(
+            !detail::has_flag(Fs, Flags::InlineOnly),
+            "std::decay_t<F> must fit inline in a BasicFunction with Flags::InlineOnly"
+        );
+
+        void *ptr;
+
+        if constexpr (HEAP_LOCATION == detail::Location::Heap) {
+            ptr = detail::Box<Obj, A>::make(alloc, std::forward<Ts>(ts)...);
+            detail::count_storage<Obj>(&detail::StorageCounters::bytes_allocated, sizeof(detail::Box<Obj, A>));
+        } else {
+            using Counted = detail::Counted<Obj, HEAP_LOCATION == detail::Location::Shared>;
+
+            ptr = detail::Box<Counted, A>::make(alloc, std::forward<Ts>(ts)...);
+            detail::count_storage<Obj>(&detail::StorageCounters::bytes_allocated, sizeof(detail::Box<Counted, A>));
+        }
+
+        detail::count_storage<Obj>(&detail::StorageCounters::heap_constructions);
+
+        new (&storage_) void*(ptr);
+        vptr_ = &get_vtbl<Obj, HEAP_LOCATION, A>();
+        this->store_invoke(vptr_);
+    }
+}
+
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+template <typename F, typename ...Ts>
+bool BasicFunction<S, Capacity, Align, Fs>::try_replace(Ts &&...ts) noexcept {
+    using Obj = std::decay_t<F>;
+    using Box = detail::Box<Obj, detail::DefaultAllocator>;
+
+    constexpr std::size_t block_size = detail::slab_block_size<Box>();
+
+    if constexpr (!std::is_nothrow_constructible_v<Obj, Ts...>) {
+        return false;
+    } else if constexpr (detail::fits_inline<Obj, Capacity, Align>()) {
+        if (is_inline()) {
+            // the arguments may refer to the wrapped object, which must
+            // not be destroyed before the new one is constructed
+            if ((detail::is_within(&storage_, sizeof(Storage), ts) || ...)) {
+                return false;
+            }
+
+            reset();
+        }
+
+        // any wrapped object left is on the free store, so it is
+        // destroyed after the new one is constructed from (ts...)
+        const VtableType *const old_vptr = std::exchange(vptr_, nullptr);
+        void *old = nullptr;
+
+        if (old_vptr) {
+            std::memcpy(&old, &storage_, sizeof(old));
+        }
 
-    if constexpr (sizeof(Obj) <= sizeof(Storage) && alignof(Storage) % alignof(Obj) == 0) {
-        is_ptr_ = false;
         new (&storage_) Obj(std::forward<Ts>(ts)...);
+        vptr_ = &get_vtbl<Obj, detail::Location::Inline, detail::DefaultAllocator>();
+        this->store_invoke(vptr_);
+        detail::count_storage<Obj>(&detail::StorageCounters::inline_constructions);
+
+        if (old_vptr) {
+            old_vptr->destroy(&old);
+        }
+
+        return true;
+    } else if constexpr (HEAP_LOCATION != detail::Location::Heap || block_size == 0) {
+        return false;
     } else {
-        const auto ptr = new Obj(std::forward<Ts>(ts)...);
+        if (!vptr_ || vptr_->block_size != block_size) {
+            return false;
+        }
+
+        void *const old = *static_cast<void**>(static_cast<void*>(&storage_));
 
-        is_ptr_ = true;
-        as_ptr() = ptr;
+        if ((detail::is_within(old, block_size, ts) || ...)) {
+            return false;
+        }
+
+        void *const block = vptr_->detach(&storage_);
+        void *const ptr = Box::make_at(block, detail::DefaultAllocator(), std::forward<Ts>(ts)...);
+
+        new (&storage_) void*(ptr);
+        vptr_ = &get_vtbl<Obj, detail::Location::Heap, detail::DefaultAllocator>();
+        this->store_invoke(vptr_);
+        detail::count_storage<Obj>(&detail::StorageCounters::heap_constructions);
+
+        return true;
     }
 }
 
-template <typename R, typename ...As>
-void*& Function<R(As...)>::as_ptr() noexcept {
-    assert(is_ptr_);
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+template <typename F, detail::Location L, typename A>
+constexpr auto BasicFunction<S, Capacity, Align, Fs>::get_vtbl() noexcept -> const VtableType& {
+    if constexpr (IS_COPYABLE) {
+        return detail::VTBL<F, L, A, S>;
+    } else {
+        return detail::MOVE_VTBL<F, L, A, S>;
+    }
+}
 
-    return *reinterpret_cast<void**>(&storage_);
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+bool BasicFunction<S, Capacity, Align, Fs>::is_trivially_relocatable() const noexcept {
+    return !vptr_ || !vptr_->relocate;
 }
 
-template <typename R, typename ...As>
-void* Function<R(As...)>::as_ptr() const noexcept {
-    assert(is_ptr_);
+template <typename S, std::size_t Capacity, std::size_t Align, Flags Fs>
+void BasicFunction<S, Capacity, Align, Fs>::relocate_from(BasicFunction &other) noexcept {
+    assert(!vptr_);
+
+    if (!other.vptr_) {
+        return;
+    }
+
+    if (other.vptr_->relocate) {
+        other.vptr_->relocate(&storage_, &other.storage_);
+    } else {
+        std::memcpy(&storage_, &other.storage_, sizeof(Storage));
+    }
 
-    return *reinterpret_cast<void *const *>(&storage_);
+    vptr_ = std::exchange(other.vptr_, nullptr);
+    this->store_invoke(vptr_);
+    detail::count_storage(vptr_, &detail::StorageCounters::moves);
 }
 
 } // namespace fn2
@@ -0,0 +1,166 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_FUNCTION_REF_H
+#define FN2_FUNCTION_REF_H
+
+#include <fn2/detail.h>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace fn2 {
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+template <typename S>
+class FunctionRef;
+#endif
+
+/**
+ *  FunctionRef is a non-owning reference to an invocable object.
+ *
+ *  FunctionRef can refer to any invocable object, including regular
+ *  functions, function pointers, function-like objects (functors),
+ *  lambda expressions, member function pointers, and member data
+ *  pointers.
+ *
+ *  FunctionRef is trivially copyable and consists of a pointer to the
+ *  referenced object and a pointer to a function that invokes it, so
+ *  it can be passed in registers. Constructing, copying and destroying
+ *  a FunctionRef never allocates or invokes any functions of the
+ *  referenced object.
+ *
+ *  The signature of a FunctionRef may be noexcept, in which case the
+ *  referenced object must be nothrow invocable and operator() is
+ *  noexcept.
+ *
+ *  FunctionRef does not extend the lifetime of the referenced object;
+ *  it is undefined behavior to invoke a FunctionRef after the object
+ *  it refers to has been destroyed. FunctionRef is intended to be
+ *  used as a function parameter type for callbacks that are not
+ *  stored beyond the duration of the call.
+ */
+template <typename R, typename ...As, bool NX>
+class FunctionRef<R(As...) noexcept(NX)> {
+public:
+    /**
+     *  @tparam std::remove_reference_t<F> must not be an object of
+     *          type FunctionRef. Must be invocable with arguments
+     *          (As...) to return type R, without throwing if this
+     *          FunctionRef's signature is noexcept.
+     *  @returns a FunctionRef that refers to f.
+     */
+    template <typename F, std::enable_if_t<
+        !std::is_same_v<std::decay_t<F>, FunctionRef>
+        && std::is_invocable_r_v<R, F&, As...>
+        && (!NX || std::is_nothrow_invocable_r_v<R, F&, As...>),
+        int
+    > = 0>
+    inline FunctionRef(F &&f) noexcept;
+
+    /**
+     *  @param this refers to an object that has not been destroyed.
+     *  @returns the result of invoking the referenced object with
+     *           parameters (std::forward<As>(as...)).
+     *
+     *  @throws any exceptions that the referenced object throws on
+     *          invocation.
+     */
+    inline R operator()(As ...as) const noexcept(NX);
+
+private:
+    union Target {
+        void *obj;
+        void (*fn)();
+    };
+
+    template <typename F>
+    static R invoke_obj(Target target, detail::Param<As> ...as) noexcept(NX);
+
+    template <typename F>
+    static R invoke_fn(Target target, detail::Param<As> ...as) noexcept(NX);
+
+    Target target_;
+    R (*invoke_)(Target target, detail::Param<As> ...as) noexcept(NX);
+};
+
+/**
+ *  @tparam std::remove_reference_t<F> must not be an object of type
+ *          FunctionRef. Must be invocable with arguments (As...) to
+ *          return type R, without throwing if this FunctionRef's
+ *          signature is noexcept.
+ *  @returns a FunctionRef that refers to f.
+ */
+template <typename R, typename ...As, bool NX>
+template <typename F, std::enable_if_t<
+    !std::is_same_v<std::decay_t<F>, FunctionRef<R(As...) noexcept(NX)>>
+    && std::is_invocable_r_v<R, F&, As...>
+    && (!NX || std::is_nothrow_invocable_r_v<R, F&, As...>),
+    int
+>>
+FunctionRef<R(As...) noexcept(NX)>::FunctionRef(F &&f) noexcept {
+    using Obj = std::remove_reference_t<F>;
+
+    if constexpr (std::is_function_v<Obj>) {
+        target_.fn = reinterpret_cast<void (*)()>(&f);
+        invoke_ = &invoke_fn<Obj*>;
+    } else if constexpr (std::is_pointer_v<Obj> && std::is_function_v<std::remove_pointer_t<Obj>>) {
+        target_.fn = reinterpret_cast<void (*)()>(f);
+        invoke_ = &invoke_fn<Obj>;
+    } else {
+        target_.obj = const_cast<void*>(static_cast<const volatile void*>(std::addressof(f)));
+        invoke_ = &invoke_obj<Obj>;
+    }
+}
+
+/**
+ *  @param this refers to an object that has not been destroyed.
+ *  @returns the result of invoking the referenced object with
+ *           parameters (std::forward<As>(as...)).
+ *
+ *  @throws any exceptions that the referenced object throws on
+ *          invocation.
+ */
+template <typename R, typename ...As, bool NX>
+R FunctionRef<R(As...) noexcept(NX)>::operator()(As ...as) const noexcept(NX) {
+    return invoke_(target_, std::forward<As>(as)...);
+}
+
+template <typename R, typename ...As, bool NX>
+template <typename F>
+R FunctionRef<R(As...) noexcept(NX)>::invoke_obj(Target target, detail::Param<As> ...as) noexcept(NX) {
+    return detail::Thunks<F&, R(As...) noexcept(NX)>::invoke(target.obj, std::forward<As>(as)...);
+}
+
+template <typename R, typename ...As, bool NX>
+template <typename F>
+R FunctionRef<R(As...) noexcept(NX)>::invoke_fn(Target target, detail::Param<As> ...as) noexcept(NX) {
+    auto fn = reinterpret_cast<F>(target.fn);
+
+    return detail::Thunks<F&, R(As...) noexcept(NX)>::invoke(&fn, std::forward<As>(as)...);
+}
+
+} // namespace fn2
+
+#endif
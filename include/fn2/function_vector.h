@@ -0,0 +1,446 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_FUNCTION_VECTOR_H
+#define FN2_FUNCTION_VECTOR_H
+
+#include <fn2/detail.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fn2 {
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+template <typename S>
+class FunctionVector;
+#endif
+
+/**
+ *  FunctionVector is a container of invocable objects that are all
+ *  invoked at once.
+ *
+ *  Wrapped objects are grouped by type into segments. Each segment
+ *  is a contiguous array of objects of a single type, with no vtable
+ *  pointer or padding to an inline capacity per element. Invoking all
+ *  wrapped objects makes one indirect call per segment, which then
+ *  invokes each of its objects directly, so they may be inlined.
+ *
+ *  Wrapped objects are invoked segment by segment, so the order of
+ *  invocation is not the order of insertion. Erasing an object may
+ *  change the order of the remaining objects in its segment.
+ *
+ *  FunctionVector is move-only. Wrapped objects must be nothrow move
+ *  constructible, since segments relocate them when they grow.
+ */
+template <typename R, typename ...As, bool NX>
+class FunctionVector<R(As...) noexcept(NX)> {
+public:
+    /** Identifies a wrapped object, so that it can be erased. */
+    using Id = std::size_t;
+
+    /** @returns a FunctionVector that does not wrap any objects. */
+    FunctionVector() noexcept = default;
+
+    /**
+     *  @param other will no longer wrap any objects.
+     *  @returns a FunctionVector that wraps the objects that other
+     *           wrapped.
+     */
+    inline FunctionVector(FunctionVector &&other) noexcept;
+
+    /** Destroys and deallocates all wrapped objects. */
+    inline ~FunctionVector();
+
+    /**
+     *  @param other will no longer wrap any objects.
+     *  @returns this FunctionVector, which now wraps the objects that
+     *           other wrapped.
+     */
+    inline FunctionVector& operator=(FunctionVector &&other) noexcept;
+
+    /**
+     *  If an exception is thrown, this FunctionVector will remain
+     *  unchanged.
+     *
+     *  @param f must not be a null pointer.
+     *  @tparam std::decay_t<F> must be constructible from (F) and
+     *          nothrow move constructible. Must be invocable as an
+     *          lvalue with lvalue arguments of types (As...) to return
+     *          type R, without throwing if this FunctionVector's
+     *          signature is noexcept.
+     *  @returns the Id of a new wrapped object of type
+     *           std::decay_t<F>, direct initialized from
+     *           (std::forward<F>(f)).
+     *
+     *  @throws std::bad_alloc
+     *  @throws any exceptions that the constructor of std::decay_t<F>
+     *          throws.
+     */
+    template <typename F>
+    inline Id push_back(F &&f);
+
+    /**
+     *  Destroys the wrapped object identified by id, if there is one.
+     *  Takes time linear in the number of wrapped objects, since the
+     *  ids of each segment are searched in turn.
+     *
+     *  @returns true if an object was erased.
+     */
+    inline bool erase(Id id) noexcept;
+
+    /**
+     *  Destroys all wrapped objects. Memory for each segment is
+     *  retained.
+     */
+    inline void clear() noexcept;
+
+    /**
+     *  Invokes each wrapped object with the lvalue arguments (as...).
+     *  Return values are discarded.
+     *
+     *  @throws any exceptions that the wrapped objects throw on
+     *          invocation. Objects after the one that threw are not
+     *          invoked.
+     */
+    inline void invoke_all(As ...as) noexcept(NX);
+
+    /** @returns the number of wrapped objects. */
+    inline std::size_t size() const noexcept;
+
+    /** @returns true if there are no wrapped objects. */
+    inline bool empty() const noexcept;
+
+private:
+    // operations on a segment of objects of a single type
+    struct Vtable {
+        void (*invoke_all)(void *data, std::size_t size, std::add_lvalue_reference_t<As> ...as) noexcept(NX);
+        // moves the last object into the object at index
+        void (*erase)(void *data, std::size_t size, std::size_t index) noexcept;
+        // destroys all objects and deallocates
+        void (*destroy)(void *data, std::size_t size, std::size_t capacity) noexcept;
+    };
+
+    struct Segment {
+        const Vtable *vptr;
+        void *data;
+        std::size_t size;
+        std::size_t capacity;
+        // ids[i] identifies the object at index i. Its capacity is at
+        // least capacity
+        std::vector<Id> ids;
+    };
+
+    template <typename F>
+    struct Ops {
+        static void invoke_all(void *data, std::size_t size, std::add_lvalue_reference_t<As> ...as) noexcept(NX);
+
+        static void erase(void *data, std::size_t size, std::size_t index) noexcept;
+
+        static void destroy(void *data, std::size_t size, std::size_t capacity) noexcept;
+
+        static void* reallocate(void *data, std::size_t size, std::size_t old_capacity, std::size_t new_capacity);
+    };
+
+    template <typename F>
+    static constexpr Vtable VTBL = {&Ops<F>::invoke_all, &Ops<F>::erase, &Ops<F>::destroy};
+
+    inline void destroy() noexcept;
+
+    std::vector<Segment> segments_;
+    std::size_t size_ = 0;
+    Id next_id_ = 0;
+};
+
+/**
+ *  @param other will no longer wrap any objects.
+ *  @returns a FunctionVector that wraps the objects that other
+ *           wrapped.
+ */
+template <typename R, typename ...As, bool NX>
+FunctionVector<R(As...) noexcept(NX)>::FunctionVector(FunctionVector &&other) noexcept
+: segments_(std::move(other.segments_)),
+  size_(std::exchange(other.size_, 0)),
+  next_id_(other.next_id_) {
+    other.segments_.clear();
+}
+
+/** Destroys and deallocates all wrapped objects. */
+template <typename R, typename ...As, bool NX>
+FunctionVector<R(As...) noexcept(NX)>::~FunctionVector() {
+    destroy();
+}
+
+/**
+ *  @param other will no longer wrap any objects.
+ *  @returns this FunctionVector, which now wraps the objects that
+ *           other wrapped.
+ */
+template <typename R, typename ...As, bool NX>
+FunctionVector<R(As...) noexcept(NX)>& FunctionVector<R(As...) noexcept(NX)>::operator=(FunctionVector &&other) noexcept {
+    if (this != &other) {
+        destroy();
+
+        segments_ = std::move(other.segments_);
+        size_ = std::exchange(other.size_, 0);
+        next_id_ = other.next_id_;
+        other.segments_.clear();
+    }
+
+    return *this;
+}
+
+/**
+ *  If an exception is thrown, this FunctionVector will remain
+ *  unchanged.
+ *
+ *  @param f must not be a null pointer.
+ *  @tparam std::decay_t<F> must be constructible from (F) and nothrow
+ *          move constructible. Must be invocable as an lvalue with
+ *          lvalue arguments of types (As...) to return type R, without
+ *          throwing if this FunctionVector's signature is noexcept.
+ *  @returns the Id of a new wrapped object of type std::decay_t<F>,
+ *           direct initialized from (std::forward<F>(f)).
+ *
+ *  @throws std::bad_alloc
+ *  @throws any exceptions that the constructor of std::decay_t<F>
+ *          throws.
+ */
+template <typename R, typename ...As, bool NX>
+template <typename F>
+auto FunctionVector<R(As...) noexcept(NX)>::push_back(F &&f) -> Id {
+    using Obj = std::decay_t<F>;
+
+    static_assert(std::is_nothrow_move_constructible_v<Obj>, "F must be nothrow move constructible");
+    static_assert(std::is_nothrow_destructible_v<Obj>, "F must be nothrow destructible");
+
+    assert(!detail::is_null<Obj>(f));
+
+    const Vtable *const vptr = &VTBL<Obj>;
+    auto segment = std::find_if(segments_.begin(), segments_.end(), [vptr](const Segment &s) {
+        return s.vptr == vptr;
+    });
+
+    const bool is_new_segment = segment == segments_.end();
+
+    if (is_new_segment) {
+        segments_.push_back(Segment{vptr, nullptr, 0, 0, {}});
+        segment = std::prev(segments_.end());
+    }
+
+    try {
+        // ids grows with the objects, and before them, so that nothing
+        // after construction can throw
+        if (segment->size == segment->capacity) {
+            const std::size_t capacity = std::max<std::size_t>(2 * segment->capacity, 1);
+
+            segment->ids.reserve(capacity);
+            segment->data = Ops<Obj>::reallocate(segment->data, segment->size, segment->capacity, capacity);
+            segment->capacity = capacity;
+        }
+
+        new (static_cast<Obj*>(segment->data) + segment->size) Obj(std::forward<F>(f));
+    } catch (...) {
+        // a segment added for this object must not be left empty
+        if (is_new_segment) {
+            Ops<Obj>::destroy(segment->data, 0, segment->capacity);
+            segments_.pop_back();
+        }
+
+        throw;
+    }
+
+    segment->ids.push_back(next_id_);
+    ++segment->size;
+    ++size_;
+
+    return next_id_++;
+}
+
+/**
+ *  Destroys the wrapped object identified by id, if there is one.
+ *  Takes time linear in the number of wrapped objects, since the ids
+ *  of each segment are searched in turn.
+ *
+ *  @returns true if an object was erased.
+ */
+template <typename R, typename ...As, bool NX>
+bool FunctionVector<R(As...) noexcept(NX)>::erase(Id id) noexcept {
+    for (Segment &segment : segments_) {
+        const auto found = std::find(segment.ids.begin(), segment.ids.end(), id);
+
+        if (found == segment.ids.end()) {
+            continue;
+        }
+
+        const auto index = static_cast<std::size_t>(found - segment.ids.begin());
+
+        segment.vptr->erase(segment.data, segment.size, index);
+        *found = segment.ids.back();
+        segment.ids.pop_back();
+        --segment.size;
+        --size_;
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ *  Destroys all wrapped objects. Memory for each segment is retained.
+ */
+template <typename R, typename ...As, bool NX>
+void FunctionVector<R(As...) noexcept(NX)>::clear() noexcept {
+    for (Segment &segment : segments_) {
+        while (segment.size > 0) {
+            segment.vptr->erase(segment.data, segment.size, segment.size - 1);
+            --segment.size;
+        }
+
+        segment.ids.clear();
+    }
+
+    size_ = 0;
+}
+
+/**
+ *  Invokes each wrapped object with the lvalue arguments (as...).
+ *  Return values are discarded.
+ *
+ *  @throws any exceptions that the wrapped objects throw on
+ *          invocation. Objects after the one that threw are not
+ *          invoked.
+ */
+template <typename R, typename ...As, bool NX>
+void FunctionVector<R(As...) noexcept(NX)>::invoke_all(As ...as) noexcept(NX) {
+    for (const Segment &segment : segments_) {
+        if (segment.size > 0) {
+            segment.vptr->invoke_all(segment.data, segment.size, as...);
+        }
+    }
+}
+
+/** @returns the number of wrapped objects. */
+template <typename R, typename ...As, bool NX>
+std::size_t FunctionVector<R(As...) noexcept(NX)>::size() const noexcept {
+    return size_;
+}
+
+/** @returns true if there are no wrapped objects. */
+template <typename R, typename ...As, bool NX>
+bool FunctionVector<R(As...) noexcept(NX)>::empty() const noexcept {
+    return size_ == 0;
+}
+
+template <typename R, typename ...As, bool NX>
+void FunctionVector<R(As...) noexcept(NX)>::destroy() noexcept {
+    for (const Segment &segment : segments_) {
+        segment.vptr->destroy(segment.data, segment.size, segment.capacity);
+    }
+
+    segments_.clear();
+    size_ = 0;
+}
+
+template <typename R, typename ...As, bool NX>
+template <typename F>
+void FunctionVector<R(As...) noexcept(NX)>::Ops<F>::invoke_all(
+    void *data, std::size_t size, std::add_lvalue_reference_t<As> ...as
+) noexcept(NX) {
+    static_assert(
+        std::is_invocable_r_v<R, F&, std::add_lvalue_reference_t<As>...>,
+        "F& must be invocable with lvalue arguments (As...) to return type R"
+    );
+    static_assert(
+        !NX || std::is_nothrow_invocable_r_v<R, F&, std::add_lvalue_reference_t<As>...>,
+        "F& must be nothrow invocable with lvalue arguments (As...) to return type R"
+    );
+
+    F *const first = static_cast<F*>(data);
+
+    for (F *f = first; f != first + size; ++f) {
+        static_cast<void>(std::invoke(*f, as...));
+    }
+}
+
+template <typename R, typename ...As, bool NX>
+template <typename F>
+void FunctionVector<R(As...) noexcept(NX)>::Ops<F>::erase(void *data, std::size_t size, std::size_t index) noexcept {
+    F *const first = static_cast<F*>(data);
+    F &last = first[size - 1];
+
+    if (index != size - 1) {
+        first[index].F::~F();
+        new (first + index) F(std::move(last));
+    }
+
+    last.F::~F();
+}
+
+template <typename R, typename ...As, bool NX>
+template <typename F>
+void FunctionVector<R(As...) noexcept(NX)>::Ops<F>::destroy(void *data, std::size_t size, std::size_t capacity) noexcept {
+    F *const first = static_cast<F*>(data);
+
+    for (F *f = first; f != first + size; ++f) {
+        f->F::~F();
+    }
+
+    if (first) {
+        std::allocator<F>().deallocate(first, capacity);
+    }
+}
+
+template <typename R, typename ...As, bool NX>
+template <typename F>
+void* FunctionVector<R(As...) noexcept(NX)>::Ops<F>::reallocate(
+    void *data, std::size_t size, std::size_t old_capacity, std::size_t new_capacity
+) {
+    std::allocator<F> alloc;
+    F *const first = static_cast<F*>(data);
+    F *const new_first = alloc.allocate(new_capacity);
+
+    for (std::size_t i = 0; i < size; ++i) {
+        new (new_first + i) F(std::move(first[i]));
+        first[i].F::~F();
+    }
+
+    if (first) {
+        alloc.deallocate(first, old_capacity);
+    }
+
+    return new_first;
+}
+
+} // namespace fn2
+
+#endif
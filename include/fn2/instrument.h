@@ -0,0 +1,155 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_INSTRUMENT_H
+#define FN2_INSTRUMENT_H
+
+#include <fn2/detail.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+namespace fn2 {
+
+/**
+ *  The number of storage operations on wrapped objects of one type
+ *  since the program started or the counts were last reset.
+ *
+ *  Counts are only kept if FN2_INSTRUMENT is defined, which adds a
+ *  pointer to every vtable and an atomic increment to each operation.
+ *  FN2_INSTRUMENT must be defined the same way in every translation
+ *  unit that includes Function2. Type names come from std::type_info,
+ *  so RTTI must be enabled.
+ */
+struct StorageStats {
+    /** The implementation-defined name of the wrapped type. */
+    const char *name;
+    /** The size, in bytes, of the wrapped type. */
+    std::size_t size;
+    /** The alignment, in bytes, of the wrapped type. */
+    std::size_t align;
+    /** The number of objects constructed inside a BasicFunction. */
+    std::uint64_t inline_constructions;
+    /** The number of objects constructed on the free store. */
+    std::uint64_t heap_constructions;
+    /** The number of times a BasicFunction was copied. */
+    std::uint64_t clones;
+    /** The number of times a BasicFunction was moved or swapped. */
+    std::uint64_t moves;
+    /**
+     *  The number of bytes allocated on the free store by construction
+     *  and copying, including each allocation's bookkeeping.
+     */
+    std::uint64_t bytes_allocated;
+};
+
+/**
+ *  @returns the counts of every wrapped type that has had a storage
+ *           operation, with the most heap constructions first. Empty
+ *           if FN2_INSTRUMENT is not defined. Thread-safe, but counts
+ *           that are concurrently modified may be inconsistent with
+ *           each other.
+ */
+inline std::vector<StorageStats> storage_stats();
+
+/** Sets every count to zero. Thread-safe. */
+inline void reset_storage_stats() noexcept;
+
+/**
+ *  Writes a table of storage_stats() to os, one line per wrapped type,
+ *  showing which types spill to the free store and how large they
+ *  are, so that the inline capacity can be chosen to fit them.
+ */
+inline void report_storage_stats(std::ostream &os);
+
+/**
+ *  @returns the counts of every wrapped type that has had a storage
+ *           operation, with the most heap constructions first. Empty
+ *           if FN2_INSTRUMENT is not defined. Thread-safe, but counts
+ *           that are concurrently modified may be inconsistent with
+ *           each other.
+ */
+std::vector<StorageStats> storage_stats() {
+    std::vector<StorageStats> stats;
+
+    for (const detail::StorageCounters *c = detail::StorageCounters::head.load(std::memory_order_acquire);
+         c;
+         c = c->next) {
+        stats.push_back({
+            c->name(),
+            c->size,
+            c->align,
+            c->inline_constructions.load(std::memory_order_relaxed),
+            c->heap_constructions.load(std::memory_order_relaxed),
+            c->clones.load(std::memory_order_relaxed),
+            c->moves.load(std::memory_order_relaxed),
+            c->bytes_allocated.load(std::memory_order_relaxed),
+        });
+    }
+
+    std::stable_sort(stats.begin(), stats.end(), [](const StorageStats &lhs, const StorageStats &rhs) {
+        return lhs.heap_constructions > rhs.heap_constructions;
+    });
+
+    return stats;
+}
+
+/** Sets every count to zero. Thread-safe. */
+void reset_storage_stats() noexcept {
+    for (detail::StorageCounters *c = detail::StorageCounters::head.load(std::memory_order_acquire);
+         c;
+         c = c->next) {
+        c->inline_constructions.store(0, std::memory_order_relaxed);
+        c->heap_constructions.store(0, std::memory_order_relaxed);
+        c->clones.store(0, std::memory_order_relaxed);
+        c->moves.store(0, std::memory_order_relaxed);
+        c->bytes_allocated.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ *  Writes a table of storage_stats() to os, one line per wrapped type,
+ *  showing which types spill to the free store and how large they
+ *  are, so that the inline capacity can be chosen to fit them.
+ */
+void report_storage_stats(std::ostream &os) {
+    os << std::setw(8) << "size" << std::setw(8) << "align"
+       << std::setw(12) << "inline" << std::setw(12) << "heap"
+       << std::setw(12) << "clones" << std::setw(12) << "moves"
+       << std::setw(14) << "bytes" << "  type\n";
+
+    for (const StorageStats &s : storage_stats()) {
+        os << std::setw(8) << s.size << std::setw(8) << s.align
+           << std::setw(12) << s.inline_constructions << std::setw(12) << s.heap_constructions
+           << std::setw(12) << s.clones << std::setw(12) << s.moves
+           << std::setw(14) << s.bytes_allocated << "  " << s.name << '\n';
+    }
+}
+
+} // namespace fn2
+
+#endif
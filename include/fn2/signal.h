@@ -0,0 +1,636 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_SIGNAL_H
+#define FN2_SIGNAL_H
+
+#include <fn2/fn2.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fn2 {
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace detail {
+
+inline std::atomic<std::uint64_t> NEXT_SIGNAL_ID{1};
+
+/**
+ *  @returns an id that no other Signal has had, so that Connections to
+ *           one Signal never identify slots of another.
+ */
+inline std::uint64_t new_signal_id() noexcept {
+    return NEXT_SIGNAL_ID.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+template <typename S>
+class Signal;
+#endif
+
+/**
+ *  Signal invokes every connected slot when it is emitted.
+ *
+ *  Slots are UniqueFunction objects stored in one contiguous array, so
+ *  a slot that fits in the inline storage of a Function is invoked
+ *  without chasing a pointer to the heap. Emitting makes one indirect
+ *  call per slot and does not allocate.
+ *
+ *  Each slot is identified by a Connection. Disconnecting a slot moves
+ *  the last slot into its place, so it takes constant time but changes
+ *  the order of invocation.
+ *
+ *  Slots may connect, disconnect and emit while this Signal is being
+ *  emitted. A slot connected during emission is first invoked by the
+ *  next outermost emission. A slot disconnected during emission is not
+ *  invoked again, but is only destroyed once the outermost emission
+ *  returns, since it may still be executing.
+ *
+ *  Signal is move-only and not thread-safe.
+ */
+template <typename ...As, bool NX>
+class Signal<void(As...) noexcept(NX)> {
+public:
+    /** The type of each slot. */
+    using Slot = UniqueFunction<void(As...) noexcept(NX)>;
+
+    /** Identifies a connected slot, so that it can be disconnected. */
+    class Connection {
+    public:
+        /** @returns a Connection that identifies no slot. */
+        Connection() noexcept = default;
+
+    private:
+        friend Signal;
+
+        constexpr Connection(std::uint64_t signal, std::uint32_t index, std::uint32_t generation) noexcept
+        : signal_(signal), index_(index), generation_(generation) { }
+
+        std::uint64_t signal_ = 0;
+        std::uint32_t index_ = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t generation_ = 0;
+    };
+
+    /** @returns a Signal with no connected slots. */
+    Signal() noexcept = default;
+
+    /**
+     *  Must not be called while other is being emitted.
+     *
+     *  @param other will have no connected slots. Connections to other
+     *         made before the move never identify its new slots.
+     *  @returns a Signal with the slots that were connected to other.
+     *           Connections to other now identify slots of this
+     *           Signal.
+     */
+    inline Signal(Signal &&other) noexcept;
+
+    /**
+     *  Must not be called while this Signal or other is being emitted.
+     *
+     *  @param other will have no connected slots. Connections to other
+     *         made before the move never identify its new slots.
+     *  @returns this Signal, which now has the slots that were
+     *           connected to other. Connections to other now identify
+     *           slots of this Signal, and Connections to this Signal
+     *           made before the move identify no slot.
+     */
+    inline Signal& operator=(Signal &&other) noexcept;
+
+    /**
+     *  If an exception is thrown, this Signal will remain unchanged.
+     *
+     *  @param f must not be a null pointer.
+     *  @tparam Slot must be constructible from (F).
+     *  @returns a Connection that identifies a new slot constructed
+     *           from (std::forward<F>(f)).
+     *
+     *  @throws std::bad_alloc
+     *  @throws any exceptions that the constructor of Slot throws.
+     */
+    template <typename F>
+    inline Connection connect(F &&f);
+
+    /**
+     *  Disconnects the slot identified by connection, if there is one.
+     *  Takes constant time.
+     *
+     *  @returns true if a slot was disconnected.
+     */
+    inline bool disconnect(Connection connection) noexcept;
+
+    /** @returns true if connection identifies a connected slot. */
+    inline bool connected(Connection connection) const noexcept;
+
+    /** Disconnects all slots. */
+    inline void clear() noexcept;
+
+    /**
+     *  Invokes each connected slot with the lvalue arguments (as...).
+     *
+     *  @throws std::bad_alloc if slots connected during a previous
+     *          emission could not be moved into the array of slots.
+     *          No slots are invoked.
+     *  @throws any exceptions that the slots throw. Slots after the
+     *          one that threw are not invoked.
+     */
+    inline void emit(As ...as);
+
+    /**
+     *  Invokes each connected slot with the lvalue arguments (as...),
+     *  split into tasks of grain slots each that are submitted to
+     *  pool. The calling thread invokes the first task and runs tasks
+     *  from pool until all tasks have finished.
+     *
+     *  While this function is executing, slots must not connect,
+     *  disconnect or emit on this Signal.
+     *
+     *  @tparam P must have member functions submit and try_run_one
+     *          with the semantics of those of ThreadPool.
+     *  @param grain if zero, one slot is invoked per task.
+     *
+     *  @throws std::bad_alloc if slots connected during a previous
+     *          emission could not be moved into the array of slots.
+     *          No slots are invoked.
+     *  @throws the first exception that a slot throws, once all tasks
+     *          have finished. Other slots in the same task are not
+     *          invoked.
+     */
+    template <typename P>
+    inline void emit_parallel(P &pool, std::size_t grain, As ...as);
+
+    /** @returns the number of connected slots. */
+    inline std::size_t size() const noexcept;
+
+    /** @returns true if there are no connected slots. */
+    inline bool empty() const noexcept;
+
+private:
+    static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+    // position is the index of a slot in slots_ or pending_, or the
+    // index of the next free handle
+    struct Handle {
+        std::uint32_t position;
+        std::uint32_t generation;
+        bool pending;
+    };
+
+    // a slot connected during emission
+    struct Pending {
+        Slot slot;
+        std::uint32_t owner;
+    };
+
+    struct ParallelEmit {
+        const Signal *self;
+        std::size_t grain;
+        std::tuple<std::add_lvalue_reference_t<As>...> args;
+        std::atomic<std::size_t> num_running;
+        std::atomic<bool> failed;
+        std::exception_ptr error;
+
+        inline void run(std::size_t first, std::size_t last) noexcept;
+    };
+
+    inline void invoke_range(std::size_t first, std::size_t last, std::add_lvalue_reference_t<As> ...as) const;
+
+    inline void begin_emit();
+
+    inline void end_emit() noexcept;
+
+    inline std::uint32_t reserve_handle();
+
+    inline void release_handle(std::uint32_t index) noexcept;
+
+    inline void erase_at(std::size_t position) noexcept;
+
+    inline void erase_pending_at(std::size_t position) noexcept;
+
+    std::vector<Slot> slots_;
+    // owners_[i] is the handle of slots_[i], or NONE if it was
+    // disconnected during emission
+    std::vector<std::uint32_t> owners_;
+    std::vector<Pending> pending_;
+    std::vector<Handle> handles_;
+    std::uint32_t free_handle_ = NONE;
+    std::size_t size_ = 0;
+    std::size_t depth_ = 0;
+    bool has_disconnected_ = false;
+    // Connections carry the id of the Signal that made them, which
+    // moves with the slots; a moved-from Signal gets a new id
+    std::uint64_t id_ = detail::new_signal_id();
+};
+
+/**
+ *  Must not be called while other is being emitted.
+ *
+ *  @param other will have no connected slots. Connections to other
+ *         made before the move never identify its new slots.
+ *  @returns a Signal with the slots that were connected to other.
+ *           Connections to other now identify slots of this Signal.
+ */
+template <typename ...As, bool NX>
+Signal<void(As...) noexcept(NX)>::Signal(Signal &&other) noexcept
+: slots_(std::move(other.slots_)),
+  owners_(std::move(other.owners_)),
+  pending_(std::move(other.pending_)),
+  handles_(std::move(other.handles_)),
+  free_handle_(std::exchange(other.free_handle_, NONE)),
+  size_(std::exchange(other.size_, 0)),
+  id_(std::exchange(other.id_, detail::new_signal_id())) {
+    other.slots_.clear();
+    other.owners_.clear();
+    other.pending_.clear();
+    other.handles_.clear();
+}
+
+/**
+ *  Must not be called while this Signal or other is being emitted.
+ *
+ *  @param other will have no connected slots. Connections to other
+ *         made before the move never identify its new slots.
+ *  @returns this Signal, which now has the slots that were connected
+ *           to other. Connections to other now identify slots of this
+ *           Signal, and Connections to this Signal made before the
+ *           move identify no slot.
+ */
+template <typename ...As, bool NX>
+Signal<void(As...) noexcept(NX)>& Signal<void(As...) noexcept(NX)>::operator=(Signal &&other) noexcept {
+    if (this != &other) {
+        slots_ = std::move(other.slots_);
+        owners_ = std::move(other.owners_);
+        pending_ = std::move(other.pending_);
+        handles_ = std::move(other.handles_);
+        free_handle_ = std::exchange(other.free_handle_, NONE);
+        size_ = std::exchange(other.size_, 0);
+        id_ = std::exchange(other.id_, detail::new_signal_id());
+        other.slots_.clear();
+        other.owners_.clear();
+        other.pending_.clear();
+        other.handles_.clear();
+    }
+
+    return *this;
+}
+
+/**
+ *  If an exception is thrown, this Signal will remain unchanged.
+ *
+ *  @param f must not be a null pointer.
+ *  @tparam Slot must be constructible from (F).
+ *  @returns a Connection that identifies a new slot constructed from
+ *           (std::forward<F>(f)).
+ *
+ *  @throws std::bad_alloc
+ *  @throws any exceptions that the constructor of Slot throws.
+ */
+template <typename ...As, bool NX>
+template <typename F>
+auto Signal<void(As...) noexcept(NX)>::connect(F &&f) -> Connection {
+    const std::uint32_t index = reserve_handle();
+    Handle &handle = handles_[index];
+    const std::uint32_t next_free = handle.position;
+
+    if (depth_ > 0) {
+        // slots_ must not reallocate while its slots may be executing
+        pending_.push_back(Pending{Slot(std::forward<F>(f)), index});
+        handle.position = static_cast<std::uint32_t>(pending_.size() - 1);
+        handle.pending = true;
+    } else {
+        owners_.push_back(index);
+
+        try {
+            slots_.emplace_back(std::forward<F>(f));
+        } catch (...) {
+            owners_.pop_back();
+
+            throw;
+        }
+
+        handle.position = static_cast<std::uint32_t>(slots_.size() - 1);
+        handle.pending = false;
+    }
+
+    free_handle_ = next_free;
+    ++size_;
+
+    return Connection(id_, index, handle.generation);
+}
+
+/**
+ *  Disconnects the slot identified by connection, if there is one.
+ *  Takes constant time.
+ *
+ *  @returns true if a slot was disconnected.
+ */
+template <typename ...As, bool NX>
+bool Signal<void(As...) noexcept(NX)>::disconnect(Connection connection) noexcept {
+    if (!connected(connection)) {
+        return false;
+    }
+
+    const Handle &handle = handles_[connection.index_];
+
+    if (handle.pending) {
+        erase_pending_at(handle.position);
+    } else if (depth_ > 0) {
+        // the slot may be executing, so it is erased by end_emit
+        owners_[handle.position] = NONE;
+        has_disconnected_ = true;
+    } else {
+        erase_at(handle.position);
+    }
+
+    release_handle(connection.index_);
+    --size_;
+
+    return true;
+}
+
+/** @returns true if connection identifies a connected slot. */
+template <typename ...As, bool NX>
+bool Signal<void(As...) noexcept(NX)>::connected(Connection connection) const noexcept {
+    return connection.signal_ == id_
+           && connection.index_ < handles_.size()
+           && handles_[connection.index_].generation == connection.generation_;
+}
+
+/** Disconnects all slots. */
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::clear() noexcept {
+    for (std::uint32_t &owner : owners_) {
+        if (owner != NONE) {
+            release_handle(std::exchange(owner, NONE));
+        }
+    }
+
+    for (const Pending &pending : pending_) {
+        release_handle(pending.owner);
+    }
+
+    pending_.clear();
+    size_ = 0;
+
+    if (depth_ > 0) {
+        has_disconnected_ = !slots_.empty();
+    } else {
+        slots_.clear();
+        owners_.clear();
+    }
+}
+
+/**
+ *  Invokes each connected slot with the lvalue arguments (as...).
+ *
+ *  @throws std::bad_alloc if slots connected during a previous
+ *          emission could not be moved into the array of slots. No
+ *          slots are invoked.
+ *  @throws any exceptions that the slots throw. Slots after the one
+ *          that threw are not invoked.
+ */
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::emit(As ...as) {
+    begin_emit();
+
+    try {
+        invoke_range(0, slots_.size(), as...);
+    } catch (...) {
+        end_emit();
+
+        throw;
+    }
+
+    end_emit();
+}
+
+/**
+ *  Invokes each connected slot with the lvalue arguments (as...),
+ *  split into tasks of grain slots each that are submitted to pool.
+ *  The calling thread invokes the first task and runs tasks from pool
+ *  until all tasks have finished.
+ *
+ *  While this function is executing, slots must not connect,
+ *  disconnect or emit on this Signal.
+ *
+ *  @tparam P must have member functions submit and try_run_one with
+ *          the semantics of those of ThreadPool.
+ *  @param grain if zero, one slot is invoked per task.
+ *
+ *  @throws std::bad_alloc if slots connected during a previous
+ *          emission could not be moved into the array of slots. No
+ *          slots are invoked.
+ *  @throws the first exception that a slot throws, once all tasks have
+ *          finished. Other slots in the same task are not invoked.
+ */
+template <typename ...As, bool NX>
+template <typename P>
+void Signal<void(As...) noexcept(NX)>::emit_parallel(P &pool, std::size_t grain, As ...as) {
+    begin_emit();
+
+    const std::size_t size = slots_.size();
+    grain = std::max(grain, std::size_t(1));
+    const std::size_t num_tasks = (size + grain - 1) / grain;
+
+    ParallelEmit context{this, grain, {as...}, {0}, {false}, nullptr};
+    std::size_t submitted = 1;
+
+    try {
+        for (; submitted < num_tasks; ++submitted) {
+            context.num_running.fetch_add(1, std::memory_order_relaxed);
+            pool.submit([&context, submitted]() noexcept {
+                const std::size_t first = submitted * context.grain;
+                const std::size_t last = std::min(first + context.grain, context.self->slots_.size());
+                context.run(first, last);
+
+                // pairs with the acquire load below, so that all
+                // slots have returned and error is visible
+                context.num_running.fetch_sub(1, std::memory_order_release);
+            });
+        }
+    } catch (...) {
+        // the task that failed to submit is invoked by this thread
+        context.num_running.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    context.run(0, std::min(grain, size));
+    context.run(std::min(submitted * grain, size), size);
+
+    while (context.num_running.load(std::memory_order_acquire) != 0) {
+        if (!pool.try_run_one()) {
+            std::this_thread::yield();
+        }
+    }
+
+    end_emit();
+
+    if (context.error) {
+        std::rethrow_exception(context.error);
+    }
+}
+
+/** @returns the number of connected slots. */
+template <typename ...As, bool NX>
+std::size_t Signal<void(As...) noexcept(NX)>::size() const noexcept {
+    return size_;
+}
+
+/** @returns true if there are no connected slots. */
+template <typename ...As, bool NX>
+bool Signal<void(As...) noexcept(NX)>::empty() const noexcept {
+    return size_ == 0;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::ParallelEmit::run(std::size_t first, std::size_t last) noexcept {
+    try {
+        std::apply([this, first, last](auto &...as) {
+            self->invoke_range(first, last, as...);
+        }, args);
+    } catch (...) {
+        if (!failed.exchange(true, std::memory_order_relaxed)) {
+            error = std::current_exception();
+        }
+    }
+}
+
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::invoke_range(std::size_t first, std::size_t last, std::add_lvalue_reference_t<As> ...as) const {
+    const Slot *const slots = slots_.data();
+    const std::uint32_t *const owners = owners_.data();
+
+    for (std::size_t i = first; i < last; ++i) {
+        if (owners[i] != NONE) {
+            slots[i](as...);
+        }
+    }
+}
+
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::begin_emit() {
+    if (depth_ == 0 && !pending_.empty()) {
+        slots_.reserve(slots_.size() + pending_.size());
+        owners_.reserve(owners_.size() + pending_.size());
+
+        for (Pending &pending : pending_) {
+            handles_[pending.owner].position = static_cast<std::uint32_t>(slots_.size());
+            handles_[pending.owner].pending = false;
+            slots_.push_back(std::move(pending.slot));
+            owners_.push_back(pending.owner);
+        }
+
+        pending_.clear();
+    }
+
+    ++depth_;
+}
+
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::end_emit() noexcept {
+    if (--depth_ > 0 || !has_disconnected_) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < slots_.size();) {
+        if (owners_[i] == NONE) {
+            erase_at(i);
+        } else {
+            ++i;
+        }
+    }
+
+    has_disconnected_ = false;
+}
+
+// returns the index of a free handle, which remains at the head of
+// the free list until connect pops it
+template <typename ...As, bool NX>
+std::uint32_t Signal<void(As...) noexcept(NX)>::reserve_handle() {
+    if (free_handle_ == NONE) {
+        if (handles_.size() >= NONE) {
+            throw std::bad_alloc();
+        }
+
+        handles_.push_back(Handle{NONE, 0, false});
+        free_handle_ = static_cast<std::uint32_t>(handles_.size() - 1);
+    }
+
+    return free_handle_;
+}
+
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::release_handle(std::uint32_t index) noexcept {
+    Handle &handle = handles_[index];
+
+    // invalidates all Connections to this handle
+    ++handle.generation;
+    handle.position = free_handle_;
+    free_handle_ = index;
+}
+
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::erase_at(std::size_t position) noexcept {
+    const std::size_t last = slots_.size() - 1;
+
+    if (position != last) {
+        slots_[position] = std::move(slots_[last]);
+        owners_[position] = owners_[last];
+
+        if (owners_[position] != NONE) {
+            handles_[owners_[position]].position = static_cast<std::uint32_t>(position);
+        }
+    }
+
+    slots_.pop_back();
+    owners_.pop_back();
+}
+
+template <typename ...As, bool NX>
+void Signal<void(As...) noexcept(NX)>::erase_pending_at(std::size_t position) noexcept {
+    const std::size_t last = pending_.size() - 1;
+
+    if (position != last) {
+        pending_[position] = std::move(pending_[last]);
+        handles_[pending_[position].owner].position = static_cast<std::uint32_t>(position);
+    }
+
+    pending_.pop_back();
+}
+#endif
+
+} // namespace fn2
+
+#endif
@@ -0,0 +1,374 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_SLAB_ALLOCATOR_H
+#define FN2_SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+
+namespace fn2 {
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace detail {
+
+// blocks no larger than this come from slabs
+inline constexpr std::size_t SLAB_MAX_SIZE = 512;
+// every block is aligned to at least this
+inline constexpr std::size_t SLAB_ALIGN = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+inline constexpr std::size_t NUM_SIZE_CLASSES = 14;
+// blocks move between thread caches and the shared pool in batches of
+// about this many bytes
+inline constexpr std::size_t SLAB_BATCH_BYTES = 16 * 1024;
+inline constexpr std::size_t SLAB_BATCHES_PER_SLAB = 4;
+
+// size classes are multiples of 16 bytes up to 128 bytes, then
+// multiples of 64 bytes up to SLAB_MAX_SIZE
+constexpr std::size_t size_class(std::size_t size) noexcept {
+    if (size <= 128) {
+        return size == 0 ? 0 : (size - 1) / 16;
+    }
+
+    return (size - 129) / 64 + 8;
+}
+
+constexpr std::size_t class_size(std::size_t c) noexcept {
+    return c < 8 ? (c + 1) * 16 : (c - 5) * 64;
+}
+
+constexpr std::size_t batch_size(std::size_t c) noexcept {
+    return SLAB_BATCH_BYTES / class_size(c);
+}
+
+// the size of the block that a SlabAllocator allocates for one T, or
+// zero if a T is not allocated from a slab
+template <typename T>
+constexpr std::size_t slab_block_size() noexcept {
+    return alignof(T) <= SLAB_ALIGN && sizeof(T) <= SLAB_MAX_SIZE ? class_size(size_class(sizeof(T))) : 0;
+}
+
+static_assert(size_class(SLAB_MAX_SIZE) == NUM_SIZE_CLASSES - 1);
+static_assert(class_size(NUM_SIZE_CLASSES - 1) == SLAB_MAX_SIZE);
+
+/**
+ *  A free block. The first block of each batch in the shared pool
+ *  also links to the next batch.
+ */
+struct FreeBlock {
+    FreeBlock *next;
+    FreeBlock *next_batch;
+};
+
+static_assert(sizeof(FreeBlock) <= class_size(0));
+
+/**
+ *  The batches of free blocks shared by all threads, and the slabs
+ *  they were carved from. Slabs are never returned to the system.
+ */
+class SlabPool {
+public:
+    // the pool is never destroyed, so that blocks can still be freed
+    // during static destruction
+    static SlabPool& get() {
+        static SlabPool *const pool = new SlabPool();
+
+        return *pool;
+    }
+
+    // @returns a batch of at least one free block of size class c
+    FreeBlock* pop_batch(std::size_t c) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!batches_[c]) {
+            carve(c);
+        }
+
+        FreeBlock *const batch = batches_[c];
+        batches_[c] = batch->next_batch;
+
+        return batch;
+    }
+
+    // batch is a null-terminated list of free blocks of size class c
+    void push_batch(std::size_t c, FreeBlock *batch) noexcept {
+        const std::lock_guard<std::mutex> lock(mutex_);
+
+        batch->next_batch = batches_[c];
+        batches_[c] = batch;
+    }
+
+private:
+    // allocates a slab and splits it into batches of size class c
+    void carve(std::size_t c) {
+        const std::size_t size = class_size(c);
+        const std::size_t batch = batch_size(c);
+        auto *const slab = static_cast<std::byte*>(
+            ::operator new(SLAB_ALIGN + SLAB_BATCHES_PER_SLAB * batch * size)
+        );
+
+        // slabs are linked through their first SLAB_ALIGN bytes so that
+        // they remain reachable
+        *static_cast<void**>(static_cast<void*>(slab)) = slabs_;
+        slabs_ = slab;
+
+        for (std::size_t i = 0; i < SLAB_BATCHES_PER_SLAB; ++i) {
+            std::byte *const first = slab + SLAB_ALIGN + i * batch * size;
+            FreeBlock *next = nullptr;
+
+            for (std::size_t j = batch; j-- > 0;) {
+                next = new (first + j * size) FreeBlock{next, nullptr};
+            }
+
+            next->next_batch = batches_[c];
+            batches_[c] = next;
+        }
+    }
+
+    std::mutex mutex_;
+    FreeBlock *batches_[NUM_SIZE_CLASSES] = {};
+    void *slabs_ = nullptr;
+};
+
+/**
+ *  The free blocks cached by one thread, which it allocates from and
+ *  frees to without synchronization.
+ */
+struct SlabCache {
+    enum class State : unsigned char {
+        // the thread has not used its cache yet
+        Unregistered,
+        Active,
+        // the thread is exiting and its cache was returned to the pool
+        Closed,
+    };
+
+    FreeBlock *lists[NUM_SIZE_CLASSES];
+    std::size_t counts[NUM_SIZE_CLASSES];
+    State state;
+};
+
+// trivially destructible, so that it can be used until the thread exits
+inline thread_local SlabCache SLAB_CACHE{};
+
+/** Returns the calling thread's cached blocks to the pool on exit. */
+struct SlabCacheCloser {
+    // odr-using this object registers its destructor
+    void open() noexcept {
+        SLAB_CACHE.state = SlabCache::State::Active;
+    }
+
+    ~SlabCacheCloser() {
+        SlabCache &cache = SLAB_CACHE;
+
+        for (std::size_t c = 0; c < NUM_SIZE_CLASSES; ++c) {
+            if (cache.lists[c]) {
+                SlabPool::get().push_batch(c, cache.lists[c]);
+                cache.lists[c] = nullptr;
+                cache.counts[c] = 0;
+            }
+        }
+
+        cache.state = SlabCache::State::Closed;
+    }
+};
+
+inline thread_local SlabCacheCloser SLAB_CACHE_CLOSER;
+
+inline void* slab_allocate_slow(std::size_t c) {
+    SlabCache &cache = SLAB_CACHE;
+
+    if (cache.state == SlabCache::State::Closed) {
+        // blocks allocated here are freed to the pool
+        return ::operator new(class_size(c));
+    }
+
+    if (cache.state == SlabCache::State::Unregistered) {
+        SLAB_CACHE_CLOSER.open();
+    }
+
+    FreeBlock *const batch = SlabPool::get().pop_batch(c);
+    std::size_t count = 0;
+
+    for (const FreeBlock *block = batch->next; block; block = block->next) {
+        ++count;
+    }
+
+    cache.lists[c] = batch->next;
+    cache.counts[c] = count;
+
+    return batch;
+}
+
+/** @returns a block of class_size(c) bytes. */
+inline void* slab_allocate(std::size_t c) {
+    SlabCache &cache = SLAB_CACHE;
+
+    if (FreeBlock *const block = cache.lists[c]) {
+        cache.lists[c] = block->next;
+        --cache.counts[c];
+
+        return block;
+    }
+
+    return slab_allocate_slow(c);
+}
+
+// returns a batch of the blocks of size class c in cache to the pool,
+// so that threads that only free blocks do not hoard them
+inline void slab_flush(SlabCache &cache, std::size_t c) noexcept {
+    const std::size_t batch = batch_size(c);
+    FreeBlock *const first = cache.lists[c];
+    FreeBlock *last = first;
+
+    for (std::size_t i = 1; i < batch; ++i) {
+        last = last->next;
+    }
+
+    cache.lists[c] = last->next;
+    cache.counts[c] -= batch;
+    last->next = nullptr;
+
+    SlabPool::get().push_batch(c, first);
+}
+
+inline void slab_deallocate_slow(FreeBlock *block, std::size_t c) noexcept {
+    SlabCache &cache = SLAB_CACHE;
+
+    if (cache.state == SlabCache::State::Closed) {
+        block->next = nullptr;
+        SlabPool::get().push_batch(c, block);
+
+        return;
+    }
+
+    SLAB_CACHE_CLOSER.open();
+
+    block->next = nullptr;
+    cache.lists[c] = block;
+    cache.counts[c] = 1;
+}
+
+/** Frees a block of class_size(c) bytes. */
+inline void slab_deallocate(void *ptr, std::size_t c) noexcept {
+    SlabCache &cache = SLAB_CACHE;
+    auto *const block = static_cast<FreeBlock*>(ptr);
+
+    if (cache.state != SlabCache::State::Active) {
+        slab_deallocate_slow(block, c);
+
+        return;
+    }
+
+    block->next = cache.lists[c];
+    cache.lists[c] = block;
+
+    if (++cache.counts[c] > 2 * batch_size(c)) {
+        slab_flush(cache, c);
+    }
+}
+
+} // namespace detail
+#endif
+
+/**
+ *  SlabAllocator is a stateless allocator for small objects, used by
+ *  default for wrapped objects that are stored on the free store.
+ *
+ *  Allocations of up to 512 bytes with an alignment no greater than
+ *  __STDCPP_DEFAULT_NEW_ALIGNMENT__ are rounded up to one of 14 size
+ *  classes. Each thread caches free blocks of each size class, so most
+ *  allocations and deallocations pop from or push to a thread-local
+ *  list. Blocks move between thread caches and a shared pool, guarded
+ *  by a mutex, in batches of about 16 KiB; the shared pool carves new
+ *  blocks out of 64 KiB slabs, which are never returned to the system.
+ *  A thread's cached blocks are returned to the shared pool when it
+ *  exits. A block may be freed by any thread.
+ *
+ *  Larger or more aligned allocations use operator new.
+ */
+template <typename T>
+class SlabAllocator {
+public:
+    using value_type = T;
+
+    SlabAllocator() noexcept = default;
+
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U>&) noexcept { }
+
+    /**
+     *  @returns storage for n objects of type T.
+     *
+     *  @throws std::bad_alloc
+     *  @throws std::bad_array_new_length if n * sizeof(T) overflows.
+     */
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+
+        const std::size_t size = n * sizeof(T);
+
+        if (IS_POOLED && size <= detail::SLAB_MAX_SIZE) {
+            return static_cast<T*>(detail::slab_allocate(detail::size_class(size)));
+        } else if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return static_cast<T*>(::operator new(size, std::align_val_t(alignof(T))));
+        } else {
+            return static_cast<T*>(::operator new(size));
+        }
+    }
+
+    /** @param ptr must have been returned by allocate(n). */
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        const std::size_t size = n * sizeof(T);
+
+        if (IS_POOLED && size <= detail::SLAB_MAX_SIZE) {
+            detail::slab_deallocate(ptr, detail::size_class(size));
+        } else if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+
+private:
+    static constexpr bool IS_POOLED = alignof(T) <= detail::SLAB_ALIGN;
+};
+
+/** @returns true, since all SlabAllocators share one pool. */
+template <typename T, typename U>
+bool operator==(const SlabAllocator<T>&, const SlabAllocator<U>&) noexcept {
+    return true;
+}
+
+/** @returns false, since all SlabAllocators share one pool. */
+template <typename T, typename U>
+bool operator!=(const SlabAllocator<T>&, const SlabAllocator<U>&) noexcept {
+    return false;
+}
+
+} // namespace fn2
+
+#endif
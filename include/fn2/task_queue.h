@@ -0,0 +1,445 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_TASK_QUEUE_H
+#define FN2_TASK_QUEUE_H
+
+#include <fn2/fn2.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fn2 {
+
+/**
+ *  BasicTaskQueue is a bounded, lock-free, multi-producer
+ *  single-consumer queue of tasks.
+ *
+ *  Each slot of the queue's ring buffer holds a
+ *  BasicUniqueFunction<void(), Capacity, Align>, so tasks are stored
+ *  inline under the same conditions as in a Function. Pushing a task
+ *  constructs it directly in its slot, and invoking a task invokes and
+ *  destroys it in its slot; tasks are only moved if they are popped.
+ *
+ *  Any number of threads may push tasks concurrently, but only one
+ *  thread at a time may invoke them.
+ *
+ *  @tparam Capacity the size, in bytes, of the inline storage of each
+ *          slot.
+ *  @tparam Align the alignment, in bytes, of the inline storage of
+ *          each slot.
+ */
+template <std::size_t Capacity = detail::DEFAULT_CAPACITY,
+          std::size_t Align = detail::DEFAULT_ALIGN>
+class BasicTaskQueue {
+public:
+    /** The type of each task. */
+    using Task = BasicUniqueFunction<void(), Capacity, Align>;
+
+    /**
+     *  @param capacity is rounded up to a power of two.
+     *  @returns a BasicTaskQueue that can hold capacity tasks.
+     *
+     *  @throws std::bad_alloc
+     */
+    inline explicit BasicTaskQueue(std::size_t capacity);
+
+    /** Destroys any tasks that were not invoked. */
+    inline ~BasicTaskQueue();
+
+    BasicTaskQueue(const BasicTaskQueue &other) = delete;
+
+    BasicTaskQueue& operator=(const BasicTaskQueue &other) = delete;
+
+    /**
+     *  Thread-safe with respect to other producers and the consumer.
+     *
+     *  @tparam std::decay_t<F> must be constructible from (F). Must be
+     *          invocable with no arguments.
+     *  @returns true if a task was constructed from
+     *           (std::forward<F>(f)) and pushed, or false if the queue
+     *           was full or f is a null pointer or an empty function
+     *           wrapper such as an empty Task, in which case no slot
+     *           is used. f may be a Task, which is
+     *           moved into the queue.
+     *
+     *  @throws std::bad_alloc
+     *  @throws any exceptions that the constructor of std::decay_t<F>
+     *          throws. If an exception is thrown, no task is pushed.
+     */
+    template <typename F>
+    inline bool try_push(F &&f);
+
+    /**
+     *  Thread-safe with respect to other producers and the consumer.
+     *
+     *  If std::decay_t<F> is a pointer or a function wrapper, the task
+     *  is constructed before it is pushed, so that it can be checked,
+     *  and moved into its slot.
+     *
+     *  @tparam std::decay_t<F> must be constructible from (Us...).
+     *          Must be invocable with no arguments.
+     *  @returns true if a task of type std::decay_t<F> was constructed
+     *           from (std::forward<Us>(us)...) and pushed, or false if
+     *           the queue was full or the task is a null pointer or an
+     *           empty function wrapper, in which case no slot is used.
+     *
+     *  @throws std::bad_alloc
+     *  @throws any exceptions that the constructor of std::decay_t<F>
+     *          throws. If an exception is thrown, no task is pushed.
+     */
+    template <typename F, typename ...Us>
+    inline bool try_emplace(Us &&...us);
+
+    /**
+     *  Invokes and destroys the oldest task, if there is one. Must only
+     *  be called by one thread at a time.
+     *
+     *  Slots that hold no task, because its constructor threw, are
+     *  released and skipped.
+     *
+     *  @returns true if a task was invoked.
+     *
+     *  @throws any exceptions that the task throws on invocation. The
+     *          task is destroyed regardless.
+     */
+    inline bool try_invoke();
+
+    /**
+     *  Moves the oldest task out of the queue, if there is one. Must
+     *  only be called by one thread at a time.
+     *
+     *  Slots that hold no task, because its constructor threw, are
+     *  released and skipped.
+     *
+     *  @returns the oldest task, or an empty Task if there was none.
+     */
+    inline Task try_pop() noexcept;
+
+    /**
+     *  Invokes and destroys tasks until the queue is empty. Must only
+     *  be called by one thread at a time.
+     *
+     *  @returns the number of tasks invoked.
+     *
+     *  @throws any exceptions that the tasks throw on invocation.
+     *          Tasks after the one that threw are not invoked.
+     */
+    inline std::size_t invoke_all();
+
+    /**
+     *  Must only be called by the thread that invokes tasks.
+     *
+     *  @returns true if there is no task ready to be invoked.
+     */
+    inline bool empty() const noexcept;
+
+    /** @returns the number of tasks this queue can hold. */
+    inline std::size_t capacity() const noexcept;
+
+private:
+    using Storage = std::aligned_storage_t<sizeof(Task), alignof(Task)>;
+
+    // a slot at position pos is ready to be pushed to if its sequence
+    // is pos, and ready to be invoked if its sequence is pos + 1. Slots
+    // have their own cache lines, so that producers pushing to adjacent
+    // slots do not contend
+    struct alignas(detail::CACHE_LINE_SIZE) Slot {
+        std::atomic<std::size_t> sequence;
+        Storage storage;
+    };
+
+    // constructs a Task from (ts...) in the next free slot
+    template <typename ...Ts>
+    inline bool push(Ts &&...ts);
+
+    inline Task& task(Slot &slot) noexcept;
+
+    inline void release(Slot &slot) noexcept;
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_;
+
+    // producers and the consumer write to different cache lines
+    alignas(detail::CACHE_LINE_SIZE) std::atomic<std::size_t> tail_{0};
+    alignas(detail::CACHE_LINE_SIZE) std::size_t head_ = 0;
+};
+
+/**
+ *  TaskQueue is a BasicTaskQueue whose slots have the default inline
+ *  capacity and alignment.
+ */
+using TaskQueue = BasicTaskQueue<>;
+
+/**
+ *  @param capacity is rounded up to a power of two.
+ *  @returns a BasicTaskQueue that can hold capacity tasks.
+ *
+ *  @throws std::bad_alloc
+ */
+template <std::size_t Capacity, std::size_t Align>
+BasicTaskQueue<Capacity, Align>::BasicTaskQueue(std::size_t capacity) {
+    std::size_t rounded = 1;
+
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+
+    slots_.reset(new Slot[rounded]);
+    mask_ = rounded - 1;
+
+    for (std::size_t i = 0; i < rounded; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+/** Destroys any tasks that were not invoked. */
+template <std::size_t Capacity, std::size_t Align>
+BasicTaskQueue<Capacity, Align>::~BasicTaskQueue() {
+    while (!empty()) {
+        release(slots_[head_ & mask_]);
+    }
+}
+
+/**
+ *  Thread-safe with respect to other producers and the consumer.
+ *
+ *  @tparam std::decay_t<F> must be constructible from (F). Must be
+ *          invocable with no arguments.
+ *  @returns true if a task was constructed from (std::forward<F>(f))
+ *           and pushed, or false if the queue was full or f is a null
+ *           pointer or an empty function wrapper such as an empty
+ *           Task, in which case no slot is used. f may be a Task,
+ *           which is moved into the queue.
+ *
+ *  @throws std::bad_alloc
+ *  @throws any exceptions that the constructor of std::decay_t<F>
+ *          throws. If an exception is thrown, no task is pushed.
+ */
+template <std::size_t Capacity, std::size_t Align>
+template <typename F>
+bool BasicTaskQueue<Capacity, Align>::try_push(F &&f) {
+    // rejected before a slot is claimed, since a claimed slot must be
+    // published
+    if (detail::is_null<std::decay_t<F>>(f)) {
+        return false;
+    }
+
+    return push(std::forward<F>(f));
+}
+
+/**
+ *  Thread-safe with respect to other producers and the consumer.
+ *
+ *  If std::decay_t<F> is a pointer or a function wrapper, the task is
+ *  constructed before it is pushed, so that it can be checked, and
+ *  moved into its slot.
+ *
+ *  @tparam std::decay_t<F> must be constructible from (Us...). Must be
+ *          invocable with no arguments.
+ *  @returns true if a task of type std::decay_t<F> was constructed from
+ *           (std::forward<Us>(us)...) and pushed, or false if the queue
+ *           was full or the task is a null pointer or an empty function
+ *           wrapper, in which case no slot is used.
+ *
+ *  @throws std::bad_alloc
+ *  @throws any exceptions that the constructor of std::decay_t<F>
+ *          throws. If an exception is thrown, no task is pushed.
+ */
+template <std::size_t Capacity, std::size_t Align>
+template <typename F, typename ...Us>
+bool BasicTaskQueue<Capacity, Align>::try_emplace(Us &&...us) {
+    using Obj = std::decay_t<F>;
+
+    if constexpr (detail::is_nullable_v<Obj>) {
+        Obj f(std::forward<Us>(us)...);
+
+        return try_push(std::move(f));
+    } else {
+        return push(std::in_place_type<F>, std::forward<Us>(us)...);
+    }
+}
+
+/**
+ *  Invokes and destroys the oldest task, if there is one. Must only be
+ *  called by one thread at a time.
+ *
+ *  Slots that hold no task, because its constructor threw, are
+ *  released and skipped.
+ *
+ *  @returns true if a task was invoked.
+ *
+ *  @throws any exceptions that the task throws on invocation. The task
+ *          is destroyed regardless.
+ */
+template <std::size_t Capacity, std::size_t Align>
+bool BasicTaskQueue<Capacity, Align>::try_invoke() {
+    while (!empty()) {
+        Slot &slot = slots_[head_ & mask_];
+        Task &t = task(slot);
+
+        // a task is empty if its constructor threw
+        if (!t) {
+            release(slot);
+
+            continue;
+        }
+
+        try {
+            t();
+        } catch (...) {
+            release(slot);
+
+            throw;
+        }
+
+        release(slot);
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ *  Moves the oldest task out of the queue, if there is one. Must only
+ *  be called by one thread at a time.
+ *
+ *  Slots that hold no task, because its constructor threw, are
+ *  released and skipped.
+ *
+ *  @returns the oldest task, or an empty Task if there was none.
+ */
+template <std::size_t Capacity, std::size_t Align>
+auto BasicTaskQueue<Capacity, Align>::try_pop() noexcept -> Task {
+    while (!empty()) {
+        Slot &slot = slots_[head_ & mask_];
+        Task t(std::move(task(slot)));
+
+        release(slot);
+
+        if (t) {
+            return t;
+        }
+    }
+
+    return Task();
+}
+
+/**
+ *  Invokes and destroys tasks until the queue is empty. Must only be
+ *  called by one thread at a time.
+ *
+ *  @returns the number of tasks invoked.
+ *
+ *  @throws any exceptions that the tasks throw on invocation. Tasks
+ *          after the one that threw are not invoked.
+ */
+template <std::size_t Capacity, std::size_t Align>
+std::size_t BasicTaskQueue<Capacity, Align>::invoke_all() {
+    std::size_t count = 0;
+
+    while (try_invoke()) {
+        ++count;
+    }
+
+    return count;
+}
+
+/**
+ *  Must only be called by the thread that invokes tasks.
+ *
+ *  @returns true if there is no task ready to be invoked.
+ */
+template <std::size_t Capacity, std::size_t Align>
+bool BasicTaskQueue<Capacity, Align>::empty() const noexcept {
+    return slots_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+}
+
+/** @returns the number of tasks this queue can hold. */
+template <std::size_t Capacity, std::size_t Align>
+std::size_t BasicTaskQueue<Capacity, Align>::capacity() const noexcept {
+    return mask_ + 1;
+}
+
+template <std::size_t Capacity, std::size_t Align>
+template <typename ...Ts>
+bool BasicTaskQueue<Capacity, Align>::push(Ts &&...ts) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot *slot;
+
+    for (;;) {
+        slot = &slots_[pos & mask_];
+
+        const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the consumer has not yet invoked the task a lap behind
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // the slot is claimed and must be published even if construction
+    // throws, or the consumer would wait on it forever
+    try {
+        new (&slot->storage) Task(std::forward<Ts>(ts)...);
+    } catch (...) {
+        new (&slot->storage) Task();
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        throw;
+    }
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <std::size_t Capacity, std::size_t Align>
+auto BasicTaskQueue<Capacity, Align>::task(Slot &slot) noexcept -> Task& {
+    return *std::launder(reinterpret_cast<Task*>(&slot.storage));
+}
+
+template <std::size_t Capacity, std::size_t Align>
+void BasicTaskQueue<Capacity, Align>::release(Slot &slot) noexcept {
+    task(slot).~Task();
+    slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+}
+
+} // namespace fn2
+
+#endif
@@ -0,0 +1,610 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_THREAD_POOL_H
+#define FN2_THREAD_POOL_H
+
+#include <fn2/fn2.h>
+#include <fn2/task_queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fn2 {
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace detail {
+
+/**
+ *  A bounded Chase-Lev work-stealing deque of Function-like objects of
+ *  type T, which must be nothrow move constructible and have an empty
+ *  state.
+ *
+ *  The owning thread pushes and pops at the bottom; any thread may
+ *  steal from the top. Objects are constructed in place in their slot
+ *  and moved out of it once claimed. Unlike the original algorithm,
+ *  which reads a slot before claiming it, a thief reads its slot after
+ *  claiming it, and each slot records whether it is occupied so that
+ *  the owner never overwrites a slot that a thief is still reading.
+ */
+template <typename T>
+class StealingDeque {
+public:
+    // capacity must be a power of two
+    explicit StealingDeque(std::size_t capacity)
+    : slots_(new Slot[capacity]), mask_(static_cast<std::int64_t>(capacity) - 1) {
+        assert((capacity & (capacity - 1)) == 0);
+    }
+
+    ~StealingDeque() {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+
+        for (std::int64_t i = top_.load(std::memory_order_relaxed); i < bottom; ++i) {
+            object(slot(i)).~T();
+        }
+    }
+
+    StealingDeque(const StealingDeque &other) = delete;
+
+    StealingDeque& operator=(const StealingDeque &other) = delete;
+
+    // owner only; returns false if the deque is full
+    template <typename ...Ts>
+    bool push(Ts &&...ts) {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t top = top_.load(std::memory_order_acquire);
+        Slot &s = slot(bottom);
+
+        if (bottom - top > mask_ || s.occupied.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        new (&s.storage) T(std::forward<Ts>(ts)...);
+        s.occupied.store(true, std::memory_order_relaxed);
+        bottom_.store(bottom + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // owner only; returns an empty T if the deque is empty
+    T pop() noexcept {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        std::int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+
+            return T();
+        }
+
+        if (top == bottom) {
+            // the last object; race thieves for it
+            const bool claimed = top_.compare_exchange_strong(
+                top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+            );
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+
+            if (!claimed) {
+                return T();
+            }
+        }
+
+        return take(slot(bottom));
+    }
+
+    // any thread; returns an empty T if the deque was empty or another
+    // thread claimed the object first
+    T steal() noexcept {
+        std::int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return T();
+        }
+
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return T();
+        }
+
+        return take(slot(top));
+    }
+
+    // any thread; may be stale by the time it returns
+    bool empty() const noexcept {
+        const std::int64_t top = top_.load(std::memory_order_acquire);
+
+        return top >= bottom_.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Slot {
+        std::atomic<bool> occupied{false};
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    };
+
+    Slot& slot(std::int64_t index) noexcept {
+        return slots_[static_cast<std::size_t>(index & mask_)];
+    }
+
+    static T& object(Slot &s) noexcept {
+        return *std::launder(reinterpret_cast<T*>(&s.storage));
+    }
+
+    // moves the object out of a claimed slot and frees the slot
+    static T take(Slot &s) noexcept {
+        T &obj = object(s);
+        T result(std::move(obj));
+
+        obj.~T();
+        s.occupied.store(false, std::memory_order_release);
+
+        return result;
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    std::int64_t mask_;
+
+    // thieves and the owner write to different cache lines
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> top_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> bottom_{0};
+};
+
+} // namespace detail
+#endif
+
+/**
+ *  ThreadPool invokes tasks on a fixed set of worker threads.
+ *
+ *  Tasks are UniqueFunction<void()> objects, so they are stored without
+ *  dynamic allocation under the same conditions as a Function. Each
+ *  worker has a Chase-Lev deque for tasks submitted by the tasks it
+ *  runs and a TaskQueue for tasks submitted by other threads. A worker
+ *  runs tasks from its own deque in last-in, first-out order, then
+ *  from its TaskQueue, and when both are empty it steals the oldest
+ *  task from another worker's deque or TaskQueue. Idle workers block
+ *  until woken by a new task.
+ *
+ *  Tasks are constructed directly in a deque or TaskQueue slot, and
+ *  are moved out of their slot once before they are invoked. A task in
+ *  a deque frees its slot for the tasks it submits, and a task in a
+ *  TaskQueue does not keep other threads from taking the tasks queued
+ *  behind it while it runs.
+ *
+ *  If a task throws an exception, std::terminate is called, whether it
+ *  is invoked by a worker or by another thread through try_run_one.
+ */
+class ThreadPool {
+public:
+    /** The type of each task. */
+    using Task = UniqueFunction<void()>;
+
+    /**
+     *  @param num_threads if zero, one worker is started.
+     *  @returns a ThreadPool with num_threads workers.
+     *
+     *  @throws std::bad_alloc
+     *  @throws std::system_error if a thread could not be started.
+     */
+    inline explicit ThreadPool(std::size_t num_threads = std::thread::hardware_concurrency());
+
+    /**
+     *  Invokes all submitted tasks, including those submitted by other
+     *  tasks, then joins each worker. Must not be called by a worker.
+     */
+    inline ~ThreadPool();
+
+    ThreadPool(const ThreadPool &other) = delete;
+
+    ThreadPool& operator=(const ThreadPool &other) = delete;
+
+    /**
+     *  Submits a task constructed from (std::forward<F>(f)). Thread-safe.
+     *
+     *  If called by a worker of this ThreadPool, the task is pushed
+     *  onto that worker's deque, or invoked immediately if the deque is
+     *  full. Otherwise, the task is pushed into a worker's TaskQueue,
+     *  waiting for space if all are full. Nothing is submitted if f is
+     *  a null pointer or an empty function wrapper such as an empty
+     *  Task.
+     *
+     *  @tparam std::decay_t<F> must be constructible from (F). Must be
+     *          invocable with no arguments.
+     *
+     *  @throws std::bad_alloc
+     *  @throws any exceptions that the constructor of std::decay_t<F>
+     *          throws.
+     */
+    template <typename F>
+    inline void submit(F &&f);
+
+    /**
+     *  Invokes one submitted task, if one can be found. Thread-safe.
+     *
+     *  Workers of this ThreadPool look in their own deque and
+     *  TaskQueue, then try to steal. Other threads steal from the
+     *  deques and TaskQueues of workers. Useful for helping while
+     *  waiting for submitted tasks to finish.
+     *
+     *  If the task throws an exception, std::terminate is called.
+     *
+     *  @returns true if a task was invoked.
+     */
+    inline bool try_run_one() noexcept;
+
+    /** @returns the number of workers. */
+    inline std::size_t size() const noexcept;
+
+private:
+    static constexpr std::size_t DEQUE_CAPACITY = 1 << 10;
+    static constexpr std::size_t INBOX_CAPACITY = 1 << 10;
+    static constexpr int NUM_SPINS = 64;
+
+    struct Worker {
+        ThreadPool *pool = nullptr;
+        detail::StealingDeque<Task> deque{DEQUE_CAPACITY};
+        TaskQueue inbox{INBOX_CAPACITY};
+
+        // held by whichever thread is popping from inbox, which only
+        // one thread may do at a time
+        std::atomic<bool> inbox_busy{false};
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool notified = false;
+        std::atomic<bool> sleeping{false};
+
+        std::thread thread;
+    };
+
+    inline Worker* current_worker() const noexcept;
+
+    inline void run(Worker &self);
+
+    // noexcept, so that a task that throws calls std::terminate on
+    // every thread, not only on workers
+    inline bool run_one(Worker *self) noexcept;
+
+    inline Task pop_inbox(Worker &worker) noexcept;
+
+    inline bool has_work() noexcept;
+
+    inline void park(Worker &self);
+
+    inline static void unpark(Worker &worker);
+
+    inline void wake_one();
+
+    static inline thread_local Worker *current_ = nullptr;
+
+    std::size_t num_workers_;
+    std::unique_ptr<Worker[]> workers_;
+    std::atomic<std::size_t> next_inbox_{0};
+    std::atomic<std::size_t> num_sleeping_{0};
+    std::atomic<bool> stop_{false};
+};
+
+/**
+ *  @param num_threads if zero, one worker is started.
+ *  @returns a ThreadPool with num_threads workers.
+ *
+ *  @throws std::bad_alloc
+ *  @throws std::system_error if a thread could not be started.
+ */
+ThreadPool::ThreadPool(std::size_t num_threads)
+: num_workers_(std::max<std::size_t>(num_threads, 1)), workers_(new Worker[num_workers_]) {
+    for (std::size_t i = 0; i < num_workers_; ++i) {
+        workers_[i].pool = this;
+    }
+
+    std::size_t started = 0;
+
+    try {
+        for (; started < num_workers_; ++started) {
+            Worker &worker = workers_[started];
+            worker.thread = std::thread([this, &worker] { run(worker); });
+        }
+    } catch (...) {
+        stop_.store(true, std::memory_order_release);
+
+        for (std::size_t i = 0; i < started; ++i) {
+            unpark(workers_[i]);
+            workers_[i].thread.join();
+        }
+
+        throw;
+    }
+}
+
+/**
+ *  Invokes all submitted tasks, including those submitted by other
+ *  tasks, then joins each worker. Must not be called by a worker.
+ */
+ThreadPool::~ThreadPool() {
+    assert(!current_worker());
+
+    stop_.store(true, std::memory_order_release);
+
+    for (std::size_t i = 0; i < num_workers_; ++i) {
+        unpark(workers_[i]);
+    }
+
+    for (std::size_t i = 0; i < num_workers_; ++i) {
+        workers_[i].thread.join();
+    }
+}
+
+/**
+ *  Submits a task constructed from (std::forward<F>(f)). Thread-safe.
+ *
+ *  If called by a worker of this ThreadPool, the task is pushed onto
+ *  that worker's deque, or invoked immediately if the deque is full.
+ *  Otherwise, the task is pushed into a worker's TaskQueue, waiting
+ *  for space if all are full. Nothing is submitted if f is a null
+ *  pointer or an empty function wrapper such as an empty Task.
+ *
+ *  @tparam std::decay_t<F> must be constructible from (F). Must be
+ *          invocable with no arguments.
+ *
+ *  @throws std::bad_alloc
+ *  @throws any exceptions that the constructor of std::decay_t<F>
+ *          throws.
+ */
+template <typename F>
+void ThreadPool::submit(F &&f) {
+    if (detail::is_null<std::decay_t<F>>(f)) {
+        return;
+    }
+
+    if (Worker *const self = current_worker()) {
+        if (self->deque.push(std::forward<F>(f))) {
+            wake_one();
+        } else {
+            const Task task(std::forward<F>(f));
+
+            if (task) {
+                task();
+            }
+        }
+
+        return;
+    }
+
+    // f is only forwarded from once, by the try_push that succeeds
+    for (;;) {
+        for (std::size_t i = 0; i < num_workers_; ++i) {
+            Worker &worker = workers_[next_inbox_.fetch_add(1, std::memory_order_relaxed) % num_workers_];
+
+            if (worker.inbox.try_push(std::forward<F>(f))) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                // if worker is busy, another may be idle and can steal
+                if (worker.sleeping.load(std::memory_order_relaxed)) {
+                    unpark(worker);
+                } else {
+                    wake_one();
+                }
+
+                return;
+            }
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+/**
+ *  Invokes one submitted task, if one can be found. Thread-safe.
+ *
+ *  Workers of this ThreadPool look in their own deque and TaskQueue,
+ *  then try to steal. Other threads steal from the deques and
+ *  TaskQueues of workers. Useful for helping while waiting for
+ *  submitted tasks to finish.
+ *
+ *  If the task throws an exception, std::terminate is called.
+ *
+ *  @returns true if a task was invoked.
+ */
+bool ThreadPool::try_run_one() noexcept {
+    return run_one(current_worker());
+}
+
+/** @returns the number of workers. */
+std::size_t ThreadPool::size() const noexcept {
+    return num_workers_;
+}
+
+auto ThreadPool::current_worker() const noexcept -> Worker* {
+    return (current_ && current_->pool == this) ? current_ : nullptr;
+}
+
+void ThreadPool::run(Worker &self) {
+    current_ = &self;
+
+    for (int idle = 0;;) {
+        if (run_one(&self)) {
+            idle = 0;
+        } else if (stop_.load(std::memory_order_acquire)) {
+            // every task submitted before stop_ was set is now visible
+            if (!run_one(&self)) {
+                break;
+            }
+        } else if (++idle < NUM_SPINS) {
+            std::this_thread::yield();
+        } else {
+            park(self);
+            idle = 0;
+        }
+    }
+
+    current_ = nullptr;
+}
+
+bool ThreadPool::run_one(Worker *self) noexcept {
+    if (self) {
+        if (const Task task = self->deque.pop()) {
+            task();
+
+            return true;
+        }
+
+        if (const Task task = pop_inbox(*self)) {
+            task();
+
+            return true;
+        }
+    }
+
+    // start stealing after self, or at an arbitrary worker
+    const std::size_t first = self ? static_cast<std::size_t>(self - workers_.get()) + 1
+                                   : next_inbox_.load(std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < num_workers_; ++i) {
+        Worker &victim = workers_[(first + i) % num_workers_];
+
+        if (&victim == self) {
+            continue;
+        }
+
+        if (const Task task = victim.deque.steal()) {
+            task();
+
+            return true;
+        }
+
+        if (const Task task = pop_inbox(victim)) {
+            task();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto ThreadPool::pop_inbox(Worker &worker) noexcept -> Task {
+    if (worker.inbox_busy.load(std::memory_order_relaxed)
+        || worker.inbox_busy.exchange(true, std::memory_order_acquire)) {
+        return Task();
+    }
+
+    Task task = worker.inbox.try_pop();
+    const bool has_more = !worker.inbox.empty();
+
+    worker.inbox_busy.store(false, std::memory_order_release);
+
+    // the task is moved out before it runs, so that an idle worker can
+    // take the rest while it does
+    if (has_more) {
+        wake_one();
+    }
+
+    return task;
+}
+
+bool ThreadPool::has_work() noexcept {
+    for (std::size_t i = 0; i < num_workers_; ++i) {
+        Worker &worker = workers_[i];
+
+        if (!worker.deque.empty()) {
+            return true;
+        }
+
+        // if another thread is popping, assume there is more to pop
+        if (worker.inbox_busy.exchange(true, std::memory_order_acquire)) {
+            return true;
+        }
+
+        const bool empty = worker.inbox.empty();
+        worker.inbox_busy.store(false, std::memory_order_release);
+
+        if (!empty) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::park(Worker &self) {
+    std::unique_lock<std::mutex> lock(self.mutex);
+
+    self.sleeping.store(true, std::memory_order_relaxed);
+    num_sleeping_.fetch_add(1, std::memory_order_relaxed);
+
+    // pairs with the fence in submit or wake_one, so that either this
+    // worker sees the new task or the submitter sees it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!has_work() && !stop_.load(std::memory_order_relaxed)) {
+        self.cv.wait(lock, [&self] { return self.notified; });
+    }
+
+    self.notified = false;
+    num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+    self.sleeping.store(false, std::memory_order_relaxed);
+}
+
+void ThreadPool::unpark(Worker &worker) {
+    {
+        const std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.notified = true;
+    }
+
+    worker.cv.notify_one();
+}
+
+void ThreadPool::wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (num_sleeping_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < num_workers_; ++i) {
+        if (workers_[i].sleeping.load(std::memory_order_relaxed)) {
+            unpark(workers_[i]);
+
+            return;
+        }
+    }
+}
+
+} // namespace fn2
+
+#endif
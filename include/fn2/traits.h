@@ -0,0 +1,49 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_TRAITS_H
+#define FN2_TRAITS_H
+
+#include <type_traits>
+
+namespace fn2 {
+
+/**
+ *  is_trivially_relocatable is true if moving an object of type T and
+ *  then destroying the source is equivalent to copying its bytes.
+ *
+ *  Function moves and swaps wrapped objects of such types with
+ *  std::memcpy instead of calling their constructors and destructors.
+ *  By default, only trivially copyable types are trivially
+ *  relocatable; users may specialize this template for their own
+ *  types.
+ */
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> { };
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+} // namespace fn2
+
+#endif
@@ -0,0 +1,88 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/algorithm.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+namespace {
+
+struct AppendTwice {
+    char ch;
+
+    void operator()(std::string &str) const {
+        str.push_back(ch);
+        str.push_back(ch);
+    }
+};
+
+} // namespace
+
+TEST_CASE("sort_by_target(It, It)", "[fn2::sort_by_target]") {
+    std::vector<fn2::Function<void(std::string&)>> functions;
+    functions.emplace_back(Append{'a'});
+    functions.emplace_back(AppendTwice{'b'});
+    functions.emplace_back(nullptr);
+    functions.emplace_back(Append{'c'});
+    functions.emplace_back(append_bang);
+    functions.emplace_back(AppendTwice{'d'});
+    functions.emplace_back(Append{'e'});
+
+    functions.emplace_back(nullptr);
+
+    const auto end = fn2::sort_by_target(functions.begin(), functions.end());
+
+    REQUIRE(end == functions.end() - 2);
+    REQUIRE_FALSE(functions[6]);
+    REQUIRE_FALSE(functions[7]);
+
+    std::string str;
+
+    for (auto it = functions.begin(); it != end; ++it) {
+        (*it)(str);
+    }
+
+    // groups are contiguous and keep their relative order
+    REQUIRE(str.size() == 8);
+    REQUIRE(str.find("ace") != std::string::npos);
+    REQUIRE(str.find("bbdd") != std::string::npos);
+    REQUIRE(str.find('!') != std::string::npos);
+
+    SECTION("no empty Functions") {
+        functions.resize(6);
+
+        REQUIRE(fn2::sort_by_target(functions.begin(), functions.end()) == functions.end());
+    }
+
+    SECTION("only empty Functions") {
+        std::vector<fn2::Function<void(std::string&)>> empty(3);
+
+        REQUIRE(fn2::sort_by_target(empty.begin(), empty.end()) == empty.begin());
+    }
+}
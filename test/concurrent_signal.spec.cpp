@@ -0,0 +1,286 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/concurrent_signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+template class fn2::ConcurrentSignal<void(std::string&)>;
+template class fn2::ConcurrentSignal<void(int) noexcept>;
+
+namespace {
+
+struct Node : fn2::detail::EpochNode {
+    explicit Node(bool &flag) noexcept : destroyed(&flag) {
+        destroy = [](fn2::detail::EpochNode *node) noexcept {
+            auto *const self = static_cast<Node*>(node);
+            *self->destroyed = true;
+            delete self;
+        };
+    }
+
+    bool *destroyed;
+};
+
+} // namespace
+
+TEST_CASE("detail::EpochDomain", "[fn2::ConcurrentSignal]") {
+    fn2::detail::EpochDomain &domain = fn2::detail::EpochDomain::get();
+    bool a = false;
+    bool b = false;
+
+    SECTION("not pinned") {
+        domain.retire(new Node(a));
+        REQUIRE(a);
+    }
+
+    SECTION("pinned by this thread") {
+        fn2::detail::epoch_pin();
+        fn2::detail::epoch_pin();
+        domain.retire(new Node(a));
+        fn2::detail::epoch_unpin();
+        REQUIRE_FALSE(a);
+
+        fn2::detail::epoch_unpin();
+        domain.retire(new Node(b));
+        REQUIRE(a);
+        REQUIRE(b);
+    }
+
+    SECTION("pinned by another thread") {
+        std::atomic<int> step{0};
+
+        std::thread reader([&step] {
+            fn2::detail::epoch_pin();
+            step.store(1);
+
+            while (step.load() != 2) {
+                std::this_thread::yield();
+            }
+
+            fn2::detail::epoch_unpin();
+        });
+
+        while (step.load() != 1) {
+            std::this_thread::yield();
+        }
+
+        domain.retire(new Node(a));
+        const bool destroyed_while_pinned = a;
+        step.store(2);
+        reader.join();
+
+        domain.retire(new Node(b));
+        REQUIRE_FALSE(destroyed_while_pinned);
+        REQUIRE(a);
+        REQUIRE(b);
+    }
+}
+
+TEST_CASE("ConcurrentSignal::connect(F&&)", "[fn2::ConcurrentSignal]") {
+    fn2::ConcurrentSignal<void(std::string&)> signal;
+    REQUIRE(signal.size() == 0);
+
+    const auto a = signal.connect(Append{'a'});
+    const auto b = signal.connect([](std::string &str) { str.append("bc"); });
+    const auto d = signal.connect([p = std::make_shared<char>('d')](std::string &str) { str.push_back(*p); });
+
+    REQUIRE(signal.size() == 3);
+    REQUIRE(signal.connected(a));
+    REQUIRE(signal.connected(b));
+    REQUIRE(signal.connected(d));
+    REQUIRE_FALSE(signal.connected({}));
+
+    std::string str;
+    signal.emit(str);
+    REQUIRE(str == "abcd");
+
+    SECTION("throwing constructor") {
+        struct Throws {
+            Throws() = default;
+
+            Throws(const Throws&) {
+                throw std::runtime_error("copy");
+            }
+
+            Throws(Throws&&) noexcept = default;
+
+            void operator()(std::string&) const { }
+        };
+
+        const Throws throws;
+        REQUIRE_THROWS_AS(signal.connect(throws), std::runtime_error);
+        REQUIRE(signal.size() == 3);
+    }
+}
+
+TEST_CASE("ConcurrentSignal slots are invoked as const", "[fn2::ConcurrentSignal]") {
+    struct Overloaded {
+        void operator()(std::string &str) {
+            str.push_back('m');
+        }
+
+        void operator()(std::string &str) const {
+            str.push_back('c');
+        }
+    };
+
+    fn2::ConcurrentSignal<void(std::string&)> signal;
+    signal.connect(Overloaded{});
+
+    std::string str;
+    signal.emit(str);
+    REQUIRE(str == "c");
+}
+
+TEST_CASE("ConcurrentSignal::disconnect(Connection)", "[fn2::ConcurrentSignal]") {
+    fn2::ConcurrentSignal<void(std::string&)> signal;
+    const auto a = signal.connect(Append{'a'});
+    const auto b = signal.connect(Append{'b'});
+    const auto c = signal.connect(Append{'c'});
+
+    REQUIRE(signal.disconnect(b));
+    REQUIRE_FALSE(signal.connected(b));
+    REQUIRE_FALSE(signal.disconnect(b));
+    REQUIRE_FALSE(signal.disconnect({}));
+
+    std::string str;
+    signal.emit(str);
+    REQUIRE(str == "ac");
+
+    REQUIRE(signal.disconnect(a));
+    REQUIRE(signal.disconnect(c));
+    REQUIRE(signal.size() == 0);
+
+    str.clear();
+    signal.emit(str);
+    REQUIRE(str.empty());
+
+    signal.connect(Append{'d'});
+    signal.clear();
+    REQUIRE(signal.size() == 0);
+}
+
+TEST_CASE("ConcurrentSignal::snapshot()", "[fn2::ConcurrentSignal]") {
+    fn2::ConcurrentSignal<void(std::string&)> signal;
+    const auto counted = std::make_shared<int>(0);
+    const auto a = signal.connect([counted](std::string &str) { str.push_back('a'); });
+
+    {
+        const auto snapshot = signal.snapshot();
+        REQUIRE(signal.disconnect(a));
+        signal.connect(Append{'b'});
+
+        // the old array is retired, but not destroyed
+        REQUIRE(counted.use_count() == 2);
+        REQUIRE(snapshot.size() == 1);
+
+        std::string str;
+
+        for (const auto &slot : snapshot) {
+            slot(str);
+        }
+
+        REQUIRE(str == "a");
+    }
+
+    signal.clear();
+    REQUIRE(counted.use_count() == 1);
+}
+
+TEST_CASE("ConcurrentSignal::emit(As...) reentrancy", "[fn2::ConcurrentSignal]") {
+    fn2::ConcurrentSignal<void(std::string&)> signal;
+    auto self = std::make_shared<fn2::ConcurrentSignal<void(std::string&)>::Connection>();
+
+    *self = signal.connect([&signal, self](std::string &str) {
+        str.push_back('a');
+        signal.disconnect(*self);
+        signal.connect(Append{'b'});
+        signal.emit(str);
+    });
+
+    std::string str;
+    signal.emit(str);
+    REQUIRE(str == "ab");
+
+    str.clear();
+    signal.emit(str);
+    REQUIRE(str == "b");
+}
+
+TEST_CASE("ConcurrentSignal concurrent emission", "[fn2::ConcurrentSignal]") {
+    constexpr int NUM_READERS = 4;
+    constexpr int NUM_EMITS = 10000;
+
+    fn2::ConcurrentSignal<void(int) noexcept> signal;
+    std::atomic<int> permanent{0};
+    std::atomic<bool> done{false};
+
+    signal.connect([&permanent](int x) noexcept { permanent.fetch_add(x, std::memory_order_relaxed); });
+
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < NUM_READERS; ++i) {
+        readers.emplace_back([&signal] {
+            for (int j = 0; j < NUM_EMITS; ++j) {
+                signal.emit(1);
+            }
+        });
+    }
+
+    std::thread writer([&signal, &done] {
+        auto counted = std::make_shared<std::atomic<int>>(0);
+        std::vector<fn2::ConcurrentSignal<void(int) noexcept>::Connection> connections;
+
+        while (!done.load()) {
+            connections.push_back(signal.connect([counted](int x) noexcept {
+                counted->fetch_add(x, std::memory_order_relaxed);
+            }));
+
+            if (connections.size() > 16) {
+                signal.disconnect(connections.front());
+                connections.erase(connections.begin());
+            }
+        }
+    });
+
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    done.store(true);
+    writer.join();
+
+    REQUIRE(permanent.load() == NUM_READERS * NUM_EMITS);
+}
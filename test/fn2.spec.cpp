@@ -23,9 +23,18 @@
 
 #include <fn2/fn2.h>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <future>
+#include <memory>
+#include <memory_resource>
 #include <numeric>
 #include <random>
+#include <stdexcept>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -34,7 +43,12 @@
 using Vector = std::vector<int>;
 using Pair = std::pair<int, int>;
 
-template class fn2::Function<int(int)>;
+template class fn2::BasicFunction<int(int)>;
+template class fn2::BasicFunction<int(int), 128, 64>;
+template class fn2::BasicFunction<int(int) const>;
+template class fn2::BasicFunction<int(int) noexcept>;
+template class fn2::BasicFunction<int(int) const noexcept>;
+template class fn2::BasicFunction<int(int) &&>;
 
 namespace {
 
@@ -637,3 +651,1164 @@ TEST_CASE("swap(Function&)", "[fn2::Function]") {
         REQUIRE(g(5) == 14);
     }
 }
+
+template <std::size_t Size, std::size_t Align>
+struct alignas(Align) AddressOf {
+    std::uintptr_t operator()() const noexcept {
+        return reinterpret_cast<std::uintptr_t>(this);
+    }
+
+    unsigned char data[Size] = {};
+};
+
+template <typename F>
+bool is_stored_inline(const F &f) {
+    const auto first = reinterpret_cast<std::uintptr_t>(&f);
+    const auto address = f();
+
+    return address >= first && address < first + sizeof(F);
+}
+
+TEST_CASE("BasicFunction<S, Capacity, Align>", "[fn2::BasicFunction]") {
+    SECTION("large object in default Function") {
+        const fn2::Function<std::uintptr_t()> f = AddressOf<96, 8>();
+
+        REQUIRE(f);
+        REQUIRE_FALSE(is_stored_inline(f));
+    }
+
+    SECTION("large object with large capacity") {
+        const fn2::BasicFunction<std::uintptr_t(), 96, 8> f = AddressOf<96, 8>();
+
+        REQUIRE(f);
+        REQUIRE(is_stored_inline(f));
+    }
+
+    SECTION("over-aligned object in default Function") {
+        const fn2::Function<std::uintptr_t()> f = AddressOf<32, 64>();
+
+        REQUIRE(f);
+        REQUIRE_FALSE(is_stored_inline(f));
+        REQUIRE(f() % 64 == 0);
+    }
+
+    SECTION("over-aligned object with large alignment") {
+        const fn2::BasicFunction<std::uintptr_t(), 64, 64> f = AddressOf<32, 64>();
+
+        REQUIRE(f);
+        REQUIRE(is_stored_inline(f));
+        REQUIRE(f() % 64 == 0);
+    }
+
+    SECTION("copy, move and swap with large capacity") {
+        fn2::BasicFunction<int(int), 128, 64> f = get_summer({2, 4, 6});
+        fn2::BasicFunction<int(int), 128, 64> g = f;
+        fn2::BasicFunction<int(int), 128, 64> h = std::move(f);
+
+        REQUIRE(g(5) == 17);
+        REQUIRE(h(5) == 17);
+
+        f = times2;
+        swap(f, h);
+
+        REQUIRE(f(5) == 17);
+        REQUIRE(h(5) == 10);
+    }
+}
+
+static_assert(std::is_copy_constructible_v<fn2::Function<int(int)>>);
+static_assert(std::is_copy_assignable_v<fn2::Function<int(int)>>);
+static_assert(!std::is_copy_constructible_v<fn2::UniqueFunction<int(int)>>);
+static_assert(!std::is_copy_assignable_v<fn2::UniqueFunction<int(int)>>);
+static_assert(std::is_nothrow_move_constructible_v<fn2::UniqueFunction<int(int)>>);
+static_assert(std::is_nothrow_move_assignable_v<fn2::UniqueFunction<int(int)>>);
+
+TEST_CASE("UniqueFunction", "[fn2::UniqueFunction]") {
+    SECTION("unique_ptr capture") {
+        fn2::UniqueFunction<int(int)> f = [p = std::make_unique<int>(2)](int x) {
+            return x * *p;
+        };
+
+        REQUIRE(f);
+        REQUIRE(f(5) == 10);
+
+        fn2::UniqueFunction<int(int)> g = std::move(f);
+
+        REQUIRE(g);
+        REQUIRE(g(5) == 10);
+    }
+
+    SECTION("huge unique_ptr capture") {
+        fn2::UniqueFunction<int(int)> f =
+            [p = std::make_unique<int>(2), gen = std::mt19937()](int x) {
+                return x * *p;
+            };
+        fn2::UniqueFunction<int(int)> g = std::move(f);
+
+        REQUIRE_FALSE(f);
+        REQUIRE(g);
+        REQUIRE(g(5) == 10);
+    }
+
+    SECTION("promise capture") {
+        std::promise<int> promise;
+        auto future = promise.get_future();
+
+        fn2::UniqueFunction<void(int)> f = [promise = std::move(promise)](int x) mutable {
+            promise.set_value(x);
+        };
+
+        f(5);
+
+        REQUIRE(future.get() == 5);
+    }
+
+    SECTION("copyable objects") {
+        fn2::UniqueFunction<int(int)> f = times2;
+        fn2::UniqueFunction<int(int)> g = get_summer({2, 4, 6});
+
+        swap(f, g);
+
+        REQUIRE(f(5) == 17);
+        REQUIRE(g(5) == 10);
+
+        f = std::move(g);
+
+        REQUIRE(f(5) == 10);
+
+        f.emplace<Multiplier>(2, 4);
+
+        REQUIRE(f(5) == 40);
+
+        f.reset();
+
+        REQUIRE_FALSE(f);
+    }
+}
+
+struct CopyCounter {
+    CopyCounter(int &copies, int &moves) noexcept : copies_(&copies), moves_(&moves) { }
+
+    CopyCounter(const CopyCounter &other) noexcept
+    : copies_(other.copies_), moves_(other.moves_) {
+        ++*copies_;
+    }
+
+    CopyCounter(CopyCounter &&other) noexcept
+    : copies_(other.copies_), moves_(other.moves_) {
+        ++*moves_;
+    }
+
+    int *copies_;
+    int *moves_;
+    char padding[64] = {};
+};
+
+TEST_CASE("operator()(As...)", "[fn2::Function]") {
+    int copies = 0;
+    int moves = 0;
+
+    SECTION("by value parameter") {
+        const fn2::Function<void(CopyCounter)> f = [](CopyCounter) { };
+
+        f(CopyCounter(copies, moves));
+
+        REQUIRE(copies == 0);
+        REQUIRE(moves == 1);
+
+        const CopyCounter counter(copies, moves);
+        f(counter);
+
+        REQUIRE(copies == 1);
+        REQUIRE(moves == 2);
+    }
+
+    SECTION("by value parameter, heap storage") {
+        const fn2::Function<void(CopyCounter)> f = [gen = std::mt19937()](CopyCounter) { };
+
+        f(CopyCounter(copies, moves));
+
+        REQUIRE(copies == 0);
+        REQUIRE(moves == 1);
+    }
+
+    SECTION("by reference parameter") {
+        const fn2::Function<void(const CopyCounter&)> f = [](const CopyCounter&) { };
+
+        f(CopyCounter(copies, moves));
+
+        REQUIRE(copies == 0);
+        REQUIRE(moves == 0);
+    }
+
+    SECTION("by rvalue reference parameter") {
+        const fn2::Function<void(CopyCounter&&)> f = [](CopyCounter &&c) {
+            static_cast<void>(CopyCounter(std::move(c)));
+        };
+
+        f(CopyCounter(copies, moves));
+
+        REQUIRE(copies == 0);
+        REQUIRE(moves == 1);
+    }
+}
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    explicit CountingAllocator(int &allocs, int &deallocs) noexcept
+    : allocs_(&allocs), deallocs_(&deallocs) { }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &other) noexcept
+    : allocs_(other.allocs_), deallocs_(other.deallocs_) { }
+
+    T* allocate(std::size_t n) {
+        ++*allocs_;
+
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        ++*deallocs_;
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U> &other) const noexcept {
+        return allocs_ == other.allocs_;
+    }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U> &other) const noexcept {
+        return allocs_ != other.allocs_;
+    }
+
+    int *allocs_;
+    int *deallocs_;
+};
+
+TEST_CASE("Function(std::allocator_arg_t, const A&, F&&)", "[fn2::Function]") {
+    int allocs = 0;
+    int deallocs = 0;
+    const CountingAllocator<char> alloc(allocs, deallocs);
+
+    SECTION("small object") {
+        {
+            const fn2::Function<int(int)> f(std::allocator_arg, alloc, times2);
+
+            REQUIRE(f(5) == 10);
+        }
+
+        REQUIRE(allocs == 0);
+        REQUIRE(deallocs == 0);
+    }
+
+    SECTION("large object") {
+        {
+            const fn2::Function<int(int)> f(std::allocator_arg, alloc, get_summer({2, 4, 6}));
+
+            REQUIRE(f(5) == 17);
+            REQUIRE(allocs == 0);
+        }
+
+        {
+            const fn2::Function<int(int)> f(std::allocator_arg, alloc, get_rand_min());
+
+            REQUIRE(f(5) >= 5);
+            REQUIRE(allocs == 1);
+        }
+
+        REQUIRE(deallocs == 1);
+    }
+
+    SECTION("copies use the same allocator") {
+        {
+            fn2::Function<int(int)> f(std::allocator_arg, alloc, get_rand_max());
+            fn2::Function<int(int)> g = f;
+
+            REQUIRE(allocs == 2);
+
+            f = times2;
+
+            REQUIRE(deallocs == 1);
+            REQUIRE(g(5) < 5);
+
+            const fn2::Function<int(int)> h = std::move(g);
+
+            REQUIRE(allocs == 2);
+            REQUIRE(h(5) < 5);
+        }
+
+        REQUIRE(deallocs == 2);
+    }
+
+    SECTION("in place construction") {
+        {
+            const fn2::UniqueFunction<std::uintptr_t()> f(
+                std::allocator_arg, alloc, std::in_place_type<AddressOf<128, 8>>
+            );
+
+            REQUIRE(f);
+            REQUIRE(allocs == 1);
+        }
+
+        REQUIRE(deallocs == 1);
+    }
+
+    SECTION("memory resource") {
+        std::array<std::byte, 1 << 15> buffer;
+        std::pmr::monotonic_buffer_resource resource(
+            buffer.data(), buffer.size(), std::pmr::null_memory_resource()
+        );
+
+        const fn2::Function<int(int)> f(std::allocator_arg, &resource, get_rand_max());
+        const fn2::Function<int(int)> g(
+            std::allocator_arg, std::pmr::polymorphic_allocator<int>(&resource), get_rand_max()
+        );
+        const fn2::Function<int(int)> h = f;
+
+        REQUIRE(f(5) < 5);
+        REQUIRE(g(5) < 5);
+        REQUIRE(h(5) < 5);
+    }
+}
+
+struct Relocatable {
+    Relocatable(int &moves, int &destroys) noexcept : moves_(&moves), destroys_(&destroys) { }
+
+    Relocatable(Relocatable &&other) noexcept
+    : moves_(other.moves_), destroys_(other.destroys_) {
+        ++*moves_;
+    }
+
+    ~Relocatable() {
+        ++*destroys_;
+    }
+
+    int operator()(int x) const noexcept {
+        return x;
+    }
+
+    int *moves_;
+    int *destroys_;
+};
+
+template <>
+struct fn2::is_trivially_relocatable<Relocatable> : std::true_type { };
+
+static_assert(fn2::is_trivially_relocatable_v<int(*)(int)>);
+static_assert(!fn2::is_trivially_relocatable_v<std::vector<int>>);
+
+TEST_CASE("trivially relocatable objects", "[fn2::Function]") {
+    SECTION("move leaves the source empty") {
+        fn2::Function<int(int)> f = [x = 2](int y) { return x * y; };
+        const fn2::Function<int(int)> g = std::move(f);
+
+        REQUIRE_FALSE(f);
+        REQUIRE(g(5) == 10);
+    }
+
+    SECTION("user specialization") {
+        int moves = 0;
+        int destroys = 0;
+
+        {
+            fn2::UniqueFunction<int(int)> f(std::in_place_type<Relocatable>, moves, destroys);
+            fn2::UniqueFunction<int(int)> g = std::move(f);
+            fn2::UniqueFunction<int(int)> h = times2;
+
+            swap(g, h);
+
+            REQUIRE_FALSE(f);
+            REQUIRE(g(5) == 10);
+            REQUIRE(h(5) == 5);
+            REQUIRE(moves == 0);
+            REQUIRE(destroys == 0);
+        }
+
+        REQUIRE(moves == 0);
+        REQUIRE(destroys == 1);
+    }
+
+    SECTION("swap with heap storage") {
+        fn2::Function<int(int)> f = [x = 2](int y) { return x * y; };
+        fn2::Function<int(int)> g = get_rand_max();
+
+        swap(f, g);
+
+        REQUIRE(f(5) < 5);
+        REQUIRE(g(5) == 10);
+
+        swap(f, g);
+
+        REQUIRE(f(5) == 10);
+        REQUIRE(g(5) < 5);
+    }
+
+    SECTION("vector growth and sorting") {
+        std::vector<std::pair<int, fn2::Function<int(int)>>> functions;
+
+        for (int i = 0; i < 64; ++i) {
+            const int priority = (i * 37) % 64;
+
+            if (i % 3 == 0) {
+                functions.emplace_back(priority, get_summer({priority}));
+            } else {
+                functions.emplace_back(priority, [priority](int x) { return x + priority; });
+            }
+        }
+
+        std::sort(functions.begin(), functions.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.first < rhs.first;
+        });
+
+        for (int i = 0; i < 64; ++i) {
+            REQUIRE(functions[static_cast<std::size_t>(i)].first == i);
+            REQUIRE(functions[static_cast<std::size_t>(i)].second(0) == i);
+        }
+    }
+}
+
+static_assert(sizeof(fn2::Function<int(int)>) == 64);
+static_assert(sizeof(fn2::UniqueFunction<int(int)>) == 64);
+static_assert(sizeof(fn2::BasicFunction<int(int), 120>) == 128);
+
+TEST_CASE("default layout", "[fn2::Function]") {
+    SECTION("largest inline object") {
+        const fn2::Function<std::uintptr_t()> f =
+            AddressOf<sizeof(fn2::Function<int(int)>) - sizeof(void*), alignof(void*)>();
+
+        REQUIRE(is_stored_inline(f));
+    }
+
+    SECTION("smallest heap object") {
+        const fn2::Function<std::uintptr_t()> f =
+            AddressOf<sizeof(fn2::Function<int(int)>), alignof(void*)>();
+
+        REQUIRE_FALSE(is_stored_inline(f));
+    }
+
+    SECTION("move leaves the source empty") {
+        fn2::Function<int(int)> f = get_summer({2, 4, 6});
+        const fn2::Function<int(int)> g = std::move(f);
+
+        REQUIRE_FALSE(f);
+        REQUIRE(g(5) == 17);
+    }
+}
+
+// like std::function, a null pointer makes an empty Function rather than
+// one that wraps a null pointer
+TEST_CASE("null pointers", "[fn2::Function]") {
+    SECTION("null function pointer") {
+        int (*ptr)(int) = nullptr;
+        const fn2::Function<int(int)> f = ptr;
+        const fn2::UniqueFunction<int(int)> u = ptr;
+
+        REQUIRE_FALSE(f);
+        REQUIRE_FALSE(u);
+    }
+
+    SECTION("null member pointers") {
+        Vector::size_type (Vector::*size)() const noexcept = nullptr;
+        const fn2::Function<Vector::size_type(const Vector&)> f = size;
+
+        int Pair::*first = nullptr;
+        const fn2::Function<const int&(const Pair&)> g = first;
+
+        REQUIRE_FALSE(f);
+        REQUIRE_FALSE(g);
+    }
+
+    SECTION("null pointer with an allocator") {
+        int allocs = 0;
+        int deallocs = 0;
+        const CountingAllocator<char> alloc(allocs, deallocs);
+        int (*ptr)(int) = nullptr;
+
+        const fn2::Function<int(int)> f(std::allocator_arg, alloc, ptr);
+
+        REQUIRE_FALSE(f);
+        REQUIRE(allocs == 0);
+    }
+
+    SECTION("assign null function pointer") {
+        int (*ptr)(int) = nullptr;
+        fn2::Function<int(int)> f = times2;
+        f = ptr;
+
+        REQUIRE_FALSE(f);
+
+        // a non-null pointer is wrapped as usual
+        ptr = times2;
+        f = ptr;
+
+        REQUIRE(f);
+        REQUIRE(f(5) == 10);
+    }
+}
+
+TEST_CASE("function pointers", "[fn2::Function]") {
+    SECTION("empty function wrappers") {
+        const fn2::Function<int(int)> empty;
+        const fn2::Function<int(int)> f = std::function<int(int)>();
+        const fn2::Function<long(int)> g = empty;
+        const fn2::UniqueFunction<int(int)> u = empty;
+        const fn2::UniqueFunction<long(int)> v = fn2::UniqueFunction<int(int)>();
+
+        REQUIRE_FALSE(f);
+        REQUIRE_FALSE(g);
+        REQUIRE_FALSE(u);
+        REQUIRE_FALSE(v);
+
+        fn2::Function<int(int)> assigned = times2;
+        assigned = std::function<int(int)>();
+
+        REQUIRE_FALSE(assigned);
+    }
+
+    SECTION("callback table") {
+        std::vector<fn2::Function<int(int)>> table = {times2, div2, nullptr, times2};
+        table.push_back(table[1]);
+
+        REQUIRE(table[0](5) == 10);
+        REQUIRE(table[1](5) == 2);
+        REQUIRE_FALSE(table[2]);
+        REQUIRE(table[3](5) == 10);
+        REQUIRE(table[4](5) == 2);
+
+        std::swap(table[0], table[1]);
+
+        REQUIRE(table[0](5) == 2);
+        REQUIRE(table[1](5) == 10);
+    }
+}
+
+TEST_CASE("Function(std::nullptr_t)", "[fn2::Function]") {
+    fn2::Function<int(int)> f = nullptr;
+
+    REQUIRE_FALSE(f);
+
+    f = times2;
+
+    REQUIRE(f);
+
+    f = nullptr;
+
+    REQUIRE_FALSE(f);
+}
+
+// the same as reset(), as for std::function
+TEST_CASE("operator=(std::nullptr_t)", "[fn2::Function]") {
+    SECTION("inline object") {
+        const auto ptr = std::make_shared<int>(0);
+        fn2::Function<int(int)> f = [ptr](int x) { return x + *ptr; };
+
+        REQUIRE(ptr.use_count() == 2);
+
+        f = nullptr;
+
+        REQUIRE_FALSE(f);
+        REQUIRE(ptr.use_count() == 1);
+    }
+
+    SECTION("heap-stored object") {
+        int allocs = 0;
+        int deallocs = 0;
+        const CountingAllocator<char> alloc(allocs, deallocs);
+        fn2::Function<int(int)> f(std::allocator_arg, alloc, get_rand_min());
+
+        REQUIRE(allocs == 1);
+
+        f = nullptr;
+
+        REQUIRE_FALSE(f);
+        REQUIRE(deallocs == 1);
+    }
+
+    SECTION("empty Function") {
+        fn2::Function<int(int)> f;
+        f = nullptr;
+
+        REQUIRE_FALSE(f);
+    }
+
+    SECTION("returns *this") {
+        fn2::UniqueFunction<int(int)> f = times2;
+
+        REQUIRE(&(f = nullptr) == &f);
+        REQUIRE_FALSE(f);
+    }
+}
+
+// comparing with nullptr is equivalent to testing operator bool, as for
+// std::function
+TEST_CASE("operator==(const Function&, std::nullptr_t)", "[fn2::Function]") {
+    SECTION("Function") {
+        fn2::Function<int(int)> f;
+
+        REQUIRE(f == nullptr);
+        REQUIRE(nullptr == f);
+        REQUIRE_FALSE(f != nullptr);
+        REQUIRE_FALSE(nullptr != f);
+
+        f = times2;
+
+        REQUIRE_FALSE(f == nullptr);
+        REQUIRE_FALSE(nullptr == f);
+        REQUIRE(f != nullptr);
+        REQUIRE(nullptr != f);
+    }
+
+    SECTION("other flags and qualified signatures") {
+        fn2::UniqueFunction<int(int) const> u;
+        fn2::SharedFunction<int(int) const noexcept> s;
+
+        REQUIRE(u == nullptr);
+        REQUIRE(nullptr == s);
+
+        u = times2;
+        s = times2;
+
+        REQUIRE(u != nullptr);
+        REQUIRE(nullptr != s);
+    }
+
+    SECTION("moved-from Function") {
+        fn2::Function<int(int)> f = get_rand_min();
+        const fn2::Function<int(int)> g = std::move(f);
+
+        REQUIRE(f == nullptr);
+        REQUIRE(g != nullptr);
+    }
+}
+
+struct Overloaded {
+    int operator()() noexcept {
+        return 0;
+    }
+
+    int operator()() const noexcept {
+        return 1;
+    }
+};
+
+struct OneShot {
+    std::unique_ptr<int> ptr;
+
+    std::unique_ptr<int> operator()() && noexcept {
+        return std::move(ptr);
+    }
+};
+
+static_assert(std::is_invocable_v<const fn2::Function<int() const>&>);
+static_assert(std::is_nothrow_invocable_v<const fn2::Function<int() noexcept>&>);
+static_assert(std::is_nothrow_invocable_v<const fn2::Function<int() const noexcept>&>);
+static_assert(!std::is_nothrow_invocable_v<const fn2::Function<int()>&>);
+static_assert(std::is_invocable_v<fn2::UniqueFunction<int() &&>>);
+static_assert(!std::is_invocable_v<fn2::UniqueFunction<int() &&>&>);
+static_assert(sizeof(fn2::Function<int(int) const noexcept>) == fn2::detail::CACHE_LINE_SIZE);
+
+// vtables are constant initialized
+static_assert(fn2::detail::VTBL<Doubler, fn2::detail::Location::Inline,
+                                fn2::detail::DefaultAllocator, int(int)>.invoke
+              == &fn2::detail::Thunks<Doubler&, int(int)>::invoke);
+static_assert(fn2::detail::VTBL<Doubler, fn2::detail::Location::Inline,
+                                fn2::detail::DefaultAllocator, int(int)>.destroy == nullptr);
+
+TEST_CASE("qualified signatures", "[fn2::Function]") {
+    SECTION("unqualified invokes a non-const lvalue") {
+        const fn2::Function<int()> f = Overloaded();
+
+        REQUIRE(f() == 0);
+    }
+
+    SECTION("const invokes a const lvalue") {
+        const fn2::Function<int() const> f = Overloaded();
+
+        REQUIRE(f() == 1);
+    }
+
+    SECTION("noexcept") {
+        const fn2::Function<int(int) noexcept> f = times2;
+        const fn2::Function<int(int) const noexcept> g = Doubler();
+
+        REQUIRE(f(5) == 10);
+        REQUIRE(g(5) == 10);
+    }
+
+    SECTION("&& invokes an rvalue") {
+        fn2::UniqueFunction<std::unique_ptr<int>() && noexcept> f =
+            OneShot{std::make_unique<int>(5)};
+        fn2::UniqueFunction<std::unique_ptr<int>() && noexcept> g = std::move(f);
+
+        const std::unique_ptr<int> ptr = std::move(g)();
+
+        REQUIRE(ptr);
+        REQUIRE(*ptr == 5);
+    }
+
+    SECTION("copy and swap") {
+        fn2::Function<int() const> f = Overloaded();
+        fn2::Function<int() const> g = [] { return 2; };
+        const fn2::Function<int() const> h = f;
+
+        swap(f, g);
+
+        REQUIRE(f() == 2);
+        REQUIRE(g() == 1);
+        REQUIRE(h() == 1);
+    }
+}
+
+template <typename S>
+using CachedFunction = fn2::BasicFunction<
+    S, fn2::detail::DEFAULT_CAPACITY - sizeof(void*), fn2::detail::DEFAULT_ALIGN,
+    fn2::Flags::CacheInvoke
+>;
+
+static_assert(sizeof(CachedFunction<int(int)>) == fn2::detail::CACHE_LINE_SIZE);
+
+TEST_CASE("Flags::CacheInvoke", "[fn2::BasicFunction]") {
+    SECTION("invoke") {
+        const CachedFunction<int(int)> f = times2;
+        const CachedFunction<int(int)> g = get_summer({2, 4, 6});
+
+        REQUIRE(f(5) == 10);
+        REQUIRE(g(5) == 17);
+        REQUIRE(is_stored_inline(CachedFunction<std::uintptr_t()>(AddressOf<48, 8>())));
+    }
+
+    SECTION("copy and move") {
+        CachedFunction<int(int)> f = get_summer({2, 4, 6});
+        const CachedFunction<int(int)> g = f;
+        const CachedFunction<int(int)> h = std::move(f);
+
+        REQUIRE_FALSE(f);
+        REQUIRE(g(5) == 17);
+        REQUIRE(h(5) == 17);
+    }
+
+    SECTION("swap") {
+        CachedFunction<int(int)> f = times2;
+        CachedFunction<int(int)> g = get_summer({2, 4, 6});
+        CachedFunction<int(int)> h;
+
+        swap(f, g);
+
+        REQUIRE(f(5) == 17);
+        REQUIRE(g(5) == 10);
+
+        swap(g, h);
+
+        REQUIRE_FALSE(g);
+        REQUIRE(h(5) == 10);
+
+        g = div2;
+
+        REQUIRE(g(5) == 2);
+    }
+
+    SECTION("move-only qualified signature") {
+        fn2::BasicFunction<std::unique_ptr<int>() && noexcept, fn2::detail::DEFAULT_CAPACITY,
+                           fn2::detail::DEFAULT_ALIGN,
+                           fn2::Flags::MoveOnly | fn2::Flags::CacheInvoke> f =
+            OneShot{std::make_unique<int>(5)};
+
+        REQUIRE(*std::move(f)() == 5);
+    }
+}
+
+namespace {
+
+// counts the live copies of itself
+struct Tracked {
+    explicit Tracked(int &live) noexcept : live_(&live) {
+        ++*live_;
+    }
+
+    Tracked(const Tracked &other) noexcept : live_(other.live_) {
+        ++*live_;
+    }
+
+    ~Tracked() {
+        --*live_;
+    }
+
+    std::uintptr_t operator()() const noexcept {
+        return reinterpret_cast<std::uintptr_t>(this);
+    }
+
+    int *live_;
+    unsigned char data[128] = {};
+};
+
+} // namespace
+
+TEST_CASE("SharedFunction", "[fn2::SharedFunction]") {
+    SECTION("copies share heap objects") {
+        int live = 0;
+
+        {
+            const fn2::SharedFunction<std::uintptr_t() const> f = Tracked(live);
+            const fn2::SharedFunction<std::uintptr_t() const> g = f;
+            fn2::SharedFunction<std::uintptr_t() const> h;
+            h = g;
+
+            REQUIRE(live == 1);
+            REQUIRE(f() == g());
+            REQUIRE(f() == h());
+            REQUIRE_FALSE(is_stored_inline(f));
+        }
+
+        REQUIRE(live == 0);
+    }
+
+    SECTION("copies do not share inline objects") {
+        const fn2::SharedFunction<std::uintptr_t() const> f = AddressOf<8, 8>();
+        const fn2::SharedFunction<std::uintptr_t() const> g = f;
+
+        REQUIRE(is_stored_inline(f));
+        REQUIRE(is_stored_inline(g));
+    }
+
+    SECTION("reassignment releases the shared object") {
+        int live = 0;
+        fn2::SharedFunction<std::uintptr_t() const> f = Tracked(live);
+        fn2::SharedFunction<std::uintptr_t() const> g = f;
+
+        f = AddressOf<8, 8>();
+
+        REQUIRE(live == 1);
+
+        g.reset();
+
+        REQUIRE(live == 0);
+    }
+
+    SECTION("copies on several threads") {
+        int live = 0;
+
+        {
+            const fn2::SharedFunction<std::uintptr_t() const> f = Tracked(live);
+            const std::uintptr_t address = f();
+            std::vector<int> matches(4);
+            std::vector<std::thread> threads;
+
+            for (int &count : matches) {
+                threads.emplace_back([f, address, &count] {
+                    for (int j = 0; j < 1000; ++j) {
+                        const fn2::SharedFunction<std::uintptr_t() const> g = f;
+
+                        count += g() == address;
+                    }
+                });
+            }
+
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+
+            REQUIRE(std::all_of(matches.cbegin(), matches.cend(), [](int count) { return count == 1000; }));
+            REQUIRE(live == 1);
+        }
+
+        REQUIRE(live == 0);
+    }
+
+    SECTION("LocalSharedFunction") {
+        int live = 0;
+
+        {
+            const fn2::LocalSharedFunction<int(int) const> f = get_summer({2, 4, 6});
+            const fn2::LocalSharedFunction<std::uintptr_t() const> g = Tracked(live);
+            const fn2::LocalSharedFunction<std::uintptr_t() const> h = g;
+
+            REQUIRE(f(5) == 17);
+            REQUIRE(g() == h());
+            REQUIRE(live == 1);
+        }
+
+        REQUIRE(live == 0);
+    }
+
+    SECTION("allocator") {
+        int allocs = 0;
+        int deallocs = 0;
+        const CountingAllocator<char> alloc(allocs, deallocs);
+
+        {
+            int live = 0;
+            const fn2::SharedFunction<std::uintptr_t() const> f(std::allocator_arg, alloc, Tracked(live));
+            const fn2::SharedFunction<std::uintptr_t() const> g = f;
+
+            REQUIRE(allocs == 1);
+            REQUIRE(f() == g());
+        }
+
+        REQUIRE(deallocs == 1);
+    }
+}
+
+static_assert(fn2::fits_inline_v<fn2::Function<int(int)>, decltype(times2)>);
+static_assert(fn2::fits_inline_v<fn2::Function<std::uintptr_t()>, AddressOf<56, 8>>);
+static_assert(fn2::fits_inline_v<fn2::Function<std::uintptr_t()>, const AddressOf<56, 8>&>);
+static_assert(!fn2::fits_inline_v<fn2::Function<std::uintptr_t()>, AddressOf<64, 8>>);
+static_assert(!fn2::fits_inline_v<fn2::Function<std::uintptr_t()>, AddressOf<8, 16>>);
+static_assert(fn2::fits_inline_v<fn2::BasicFunction<std::uintptr_t(), 16, 16>, AddressOf<8, 16>>);
+
+TEST_CASE("BasicFunction::is_inline()", "[fn2::BasicFunction]") {
+    SECTION("empty") {
+        const fn2::Function<int(int)> f;
+
+        REQUIRE_FALSE(f.is_inline());
+    }
+
+    SECTION("agrees with fits_inline_v") {
+        const fn2::Function<std::uintptr_t()> f = AddressOf<56, 8>();
+        const fn2::Function<std::uintptr_t()> g = AddressOf<64, 8>();
+
+        REQUIRE(f.is_inline());
+        REQUIRE(is_stored_inline(f));
+        REQUIRE_FALSE(g.is_inline());
+        REQUIRE_FALSE(is_stored_inline(g));
+    }
+
+    SECTION("follows moves and swaps") {
+        fn2::Function<std::uintptr_t()> f = AddressOf<56, 8>();
+        fn2::Function<std::uintptr_t()> g = AddressOf<64, 8>();
+
+        swap(f, g);
+
+        REQUIRE_FALSE(f.is_inline());
+        REQUIRE(g.is_inline());
+
+        const fn2::Function<std::uintptr_t()> h = std::move(g);
+
+        REQUIRE_FALSE(g.is_inline());
+        REQUIRE(h.is_inline());
+    }
+}
+
+TEST_CASE("InlineOnlyFunction", "[fn2::InlineOnlyFunction]") {
+    int allocs = 0;
+    int deallocs = 0;
+    const CountingAllocator<char> alloc(allocs, deallocs);
+
+    SECTION("invoke") {
+        fn2::InlineOnlyFunction<int(int)> f = times2;
+        const fn2::InlineOnlyFunction<int(int)> g = f;
+
+        REQUIRE(f(5) == 10);
+        REQUIRE(g(5) == 10);
+        REQUIRE(g.is_inline());
+
+        f = div2;
+
+        REQUIRE(f(5) == 2);
+    }
+
+    SECTION("larger capacity") {
+        const fn2::BasicInlineOnlyFunction<std::uintptr_t(), 128> f(
+            std::allocator_arg, alloc, AddressOf<128, 8>()
+        );
+
+        REQUIRE(is_stored_inline(f));
+        REQUIRE(allocs == 0);
+    }
+}
+
+namespace {
+
+// stored on the free store; copying it throws
+struct ThrowingHeapObject {
+    ThrowingHeapObject() = default;
+
+    ThrowingHeapObject(const ThrowingHeapObject&) {
+        throw std::runtime_error("ThrowingHeapObject");
+    }
+
+    ThrowingHeapObject(ThrowingHeapObject&&) noexcept = default;
+
+    std::uintptr_t operator()() const noexcept {
+        return 0;
+    }
+
+    unsigned char data[128] = {};
+};
+
+} // namespace
+
+TEST_CASE("heap block reuse", "[fn2::Function]") {
+    SECTION("operator=(F&&) reuses a block of the same size class") {
+        fn2::Function<std::uintptr_t()> f = AddressOf<128, 8>();
+        const std::uintptr_t address = f();
+
+        f = AddressOf<120, 8>();
+
+        REQUIRE(f() == address);
+        REQUIRE_FALSE(f.is_inline());
+    }
+
+    SECTION("emplace reuses a block of the same size class") {
+        fn2::Function<std::uintptr_t()> f = AddressOf<128, 8>();
+        const std::uintptr_t address = f();
+
+        f.emplace<AddressOf<128, 8>>();
+
+        REQUIRE(f() == address);
+    }
+
+    SECTION("objects that may throw on construction are not reused") {
+        fn2::Function<std::uintptr_t()> f = AddressOf<128, 8>();
+        const std::uintptr_t address = f();
+        const ThrowingHeapObject throws;
+
+        REQUIRE_THROWS_AS(f = throws, std::runtime_error);
+        REQUIRE(f() == address);
+    }
+
+    SECTION("arguments that refer to the wrapped object") {
+        fn2::Function<std::uintptr_t()> f = AddressOf<128, 8>();
+        const std::uintptr_t address = f();
+
+        f = *reinterpret_cast<const AddressOf<128, 8>*>(address);
+
+        REQUIRE(f() != address);
+    }
+
+    SECTION("blocks from other allocators are not reused") {
+        int allocs = 0;
+        int deallocs = 0;
+        fn2::Function<std::uintptr_t()> f(
+            std::allocator_arg, CountingAllocator<char>(allocs, deallocs), AddressOf<128, 8>()
+        );
+
+        f = AddressOf<128, 8>();
+
+        REQUIRE(deallocs == 1);
+    }
+
+    SECTION("shared blocks are not reused") {
+        fn2::SharedFunction<std::uintptr_t() const> f = AddressOf<128, 8>();
+        const fn2::SharedFunction<std::uintptr_t() const> g = f;
+
+        f = AddressOf<128, 8>();
+
+        REQUIRE(f() != g());
+    }
+}
+
+namespace {
+
+// returns a pointer to itself, and shares ownership of value, so that
+// copying from a destroyed SelfRef is a use after free
+template <std::size_t PadSize>
+struct SelfRef {
+    std::shared_ptr<int> value;
+    std::array<char, PadSize> pad;
+
+    const SelfRef* operator()() const noexcept {
+        return this;
+    }
+};
+
+// counts its moves and destructions, and is not trivially relocatable
+struct MoveCounter {
+    MoveCounter(int &moves, int &destroys) noexcept : moves_(&moves), destroys_(&destroys) { }
+
+    MoveCounter(MoveCounter &&other) noexcept
+    : moves_(other.moves_), destroys_(other.destroys_) {
+        ++*moves_;
+    }
+
+    ~MoveCounter() {
+        ++*destroys_;
+    }
+
+    int operator()(int x) const noexcept {
+        return x;
+    }
+
+    int *moves_;
+    int *destroys_;
+};
+
+} // namespace
+
+TEST_CASE("in-place replacement", "[fn2::Function]") {
+    int moves = 0;
+    int destroys = 0;
+
+    SECTION("emplace constructs in storage") {
+        fn2::UniqueFunction<int(int)> f = MoveCounter(moves, destroys);
+
+        moves = 0;
+        destroys = 0;
+        f.emplace<MoveCounter>(moves, destroys);
+
+        REQUIRE(f(5) == 5);
+        REQUIRE(moves == 0);
+        REQUIRE(destroys == 1);
+    }
+
+    SECTION("operator=(F&&) moves once") {
+        fn2::UniqueFunction<int(int)> f = times2;
+
+        f = MoveCounter(moves, destroys);
+
+        REQUIRE(f(5) == 5);
+        REQUIRE(moves == 1);
+        REQUIRE(destroys == 1);
+    }
+
+    SECTION("replaces a heap object") {
+        fn2::Function<std::uintptr_t()> f = AddressOf<128, 8>();
+
+        f = AddressOf<8, 8>();
+
+        REQUIRE(f.is_inline());
+        REQUIRE(is_stored_inline(f));
+    }
+
+    SECTION("arguments that refer to the wrapped object") {
+        // without the aliasing check, the old object and the last
+        // reference to its value would be destroyed before the copy
+        const auto replace_with_self = [](auto f) {
+            f = *f();
+            REQUIRE(*f()->value == 42);
+            REQUIRE(f()->value.use_count() == 1);
+
+            using Obj = std::remove_cv_t<std::remove_pointer_t<decltype(f())>>;
+            f.template emplace<Obj>(*f());
+            REQUIRE(*f()->value == 42);
+            REQUIRE(f()->value.use_count() == 1);
+
+            return f;
+        };
+
+        fn2::Function<const SelfRef<0>*()> inline_f = SelfRef<0>{std::make_shared<int>(42), {}};
+        REQUIRE(inline_f.is_inline());
+        REQUIRE(replace_with_self(std::move(inline_f)).is_inline());
+
+        fn2::Function<const SelfRef<96>*()> heap_f = SelfRef<96>{std::make_shared<int>(42), {}};
+        REQUIRE_FALSE(heap_f.is_inline());
+        REQUIRE_FALSE(replace_with_self(std::move(heap_f)).is_inline());
+    }
+
+    SECTION("assigning null") {
+        fn2::Function<int(int)> f = times2;
+        int (*const null)(int) = nullptr;
+
+        f = null;
+
+        REQUIRE_FALSE(f);
+
+        f = times2;
+        f = nullptr;
+
+        REQUIRE_FALSE(f);
+    }
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/function_ref.h>
+
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using Vector = std::vector<int>;
+using Pair = std::pair<int, int>;
+
+template class fn2::FunctionRef<int(int)>;
+template class fn2::FunctionRef<int(int) noexcept>;
+
+static_assert(std::is_trivially_copyable_v<fn2::FunctionRef<int(int)>>);
+static_assert(sizeof(fn2::FunctionRef<int(int)>) == 2 * sizeof(void*));
+static_assert(std::is_nothrow_invocable_v<fn2::FunctionRef<int(int) noexcept>, int>);
+static_assert(!std::is_convertible_v<int (*)(int), fn2::FunctionRef<int(int) noexcept>>);
+
+namespace {
+
+constexpr int times2(int x) noexcept {
+    return x * 2;
+}
+
+int apply(fn2::FunctionRef<int(int)> f, int x) {
+    return f(x);
+}
+
+} // namespace
+
+TEST_CASE("FunctionRef(F&&)", "[fn2::FunctionRef]") {
+    SECTION("regular function") {
+        const fn2::FunctionRef<int(int)> f = times2;
+
+        REQUIRE(f(5) == 10);
+        REQUIRE(apply(times2, 5) == 10);
+    }
+
+    SECTION("function pointer") {
+        int (*ptr)(int) = times2;
+        const fn2::FunctionRef<int(int)> f = ptr;
+        ptr = nullptr;
+
+        REQUIRE(f(5) == 10);
+    }
+
+    SECTION("lambda expression") {
+        REQUIRE(apply([](int x) { return x * 2; }, 5) == 10);
+    }
+
+    SECTION("stateful lambda expression") {
+        int calls = 0;
+        auto counter = [&calls](int x) {
+            ++calls;
+
+            return x + calls;
+        };
+        const fn2::FunctionRef<int(int)> f = counter;
+
+        REQUIRE(f(5) == 6);
+        REQUIRE(f(5) == 7);
+        REQUIRE(calls == 2);
+    }
+
+    SECTION("refers to the original object") {
+        std::vector<int> coefs = {2, 4, 6};
+        const auto summer = [&coefs](int init) {
+            return std::accumulate(coefs.cbegin(), coefs.cend(), init);
+        };
+        const fn2::FunctionRef<int(int)> f = summer;
+
+        REQUIRE(f(5) == 17);
+
+        coefs.push_back(8);
+
+        REQUIRE(f(5) == 25);
+    }
+
+    SECTION("pointer to member function") {
+        const auto size = &Vector::size;
+        const fn2::FunctionRef<Vector::size_type(const Vector&)> f = size;
+        const Vector v = {0, 1, 2, 3};
+
+        REQUIRE(f(v) == 4);
+    }
+
+    SECTION("pointer to member data") {
+        const auto first = &Pair::first;
+        const fn2::FunctionRef<const int&(const Pair&)> f = first;
+        const Pair p = {0, 1};
+
+        REQUIRE(f(p) == 0);
+    }
+
+    SECTION("copy") {
+        const auto doubler = [](int x) { return x * 2; };
+        const fn2::FunctionRef<int(int)> f = doubler;
+        fn2::FunctionRef<int(int)> g = times2;
+
+        g = f;
+
+        REQUIRE(g(5) == 10);
+    }
+
+    SECTION("algorithm callback") {
+        std::vector<int> v = {3, 1, 2};
+        const fn2::FunctionRef<bool(int, int)> less = [](int x, int y) { return x < y; };
+
+        std::sort(v.begin(), v.end(), less);
+
+        REQUIRE(v == std::vector<int>{1, 2, 3});
+    }
+
+    SECTION("noexcept") {
+        const auto add = [y = 2](int x) noexcept { return x + y; };
+        const fn2::FunctionRef<int(int) noexcept> f = add;
+        const fn2::FunctionRef<int(int) noexcept> g = times2;
+
+        REQUIRE(f(5) == 7);
+        REQUIRE(g(5) == 10);
+    }
+}
@@ -0,0 +1,204 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/function_vector.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+template class fn2::FunctionVector<void(std::string&)>;
+template class fn2::FunctionVector<int(int) noexcept>;
+
+TEST_CASE("FunctionVector::push_back(F&&)", "[fn2::FunctionVector]") {
+    SECTION("empty") {
+        fn2::FunctionVector<void(std::string&)> functions;
+        std::string str;
+
+        functions.invoke_all(str);
+
+        REQUIRE(functions.empty());
+        REQUIRE(str.empty());
+    }
+
+    SECTION("objects of several types") {
+        fn2::FunctionVector<void(std::string&)> functions;
+        functions.push_back(Append{'a'});
+        functions.push_back(append_bang);
+        functions.push_back([](std::string &str) { str.push_back('b'); });
+        functions.push_back(Append{'c'});
+
+        std::string str;
+        functions.invoke_all(str);
+
+        REQUIRE(functions.size() == 4);
+        REQUIRE(sorted(str) == "!abc");
+        // objects of the same type are invoked together, in order
+        REQUIRE(str.find("ac") != std::string::npos);
+    }
+
+    SECTION("many objects") {
+        fn2::FunctionVector<void(int&)> functions;
+
+        // quadratic growth of a segment would make this take seconds
+        for (int i = 0; i < 50000; ++i) {
+            functions.push_back([i](int &sum) { sum += i; });
+            functions.push_back([](int &sum) { ++sum; });
+        }
+
+        int sum = 0;
+        functions.invoke_all(sum);
+
+        REQUIRE(functions.size() == 100000);
+        REQUIRE(sum == 49999 * (50000 / 2) + 50000);
+    }
+
+    SECTION("move-only objects") {
+        fn2::FunctionVector<int(int) noexcept> functions;
+        functions.push_back([ptr = std::make_unique<int>(5)](int x) noexcept { return x + *ptr; });
+
+        functions.invoke_all(1);
+
+        REQUIRE(functions.size() == 1);
+    }
+
+    SECTION("destroys objects") {
+        const auto ptr = std::make_shared<int>(0);
+
+        {
+            fn2::FunctionVector<void()> functions;
+
+            for (int i = 0; i < 10; ++i) {
+                functions.push_back([ptr] { ++*ptr; });
+            }
+
+            functions.invoke_all();
+
+            REQUIRE(*ptr == 10);
+            REQUIRE(ptr.use_count() == 11);
+        }
+
+        REQUIRE(ptr.use_count() == 1);
+    }
+
+    SECTION("throwing constructor") {
+        fn2::FunctionVector<void(std::string&)> functions;
+        functions.push_back(Append{'a'});
+
+        const ThrowOnCopy throwing(true);
+        const ThrowOnCopy copyable(false);
+
+        // the first object of a new type
+        REQUIRE_THROWS_AS(functions.push_back(throwing), std::runtime_error);
+        REQUIRE(functions.size() == 1);
+
+        std::string str;
+        functions.invoke_all(str);
+        REQUIRE(str == "a");
+
+        // the segment for the type is created again, then grows
+        functions.push_back(copyable);
+        REQUIRE_THROWS_AS(functions.push_back(throwing), std::runtime_error);
+        functions.push_back(copyable);
+        REQUIRE(functions.size() == 3);
+
+        str.clear();
+        functions.invoke_all(str);
+        REQUIRE(sorted(str) == "att");
+    }
+}
+
+TEST_CASE("FunctionVector::erase(Id)", "[fn2::FunctionVector]") {
+    const auto ptr = std::make_shared<int>(0);
+
+    fn2::FunctionVector<void(std::string&)> functions;
+    const auto a = functions.push_back(Append{'a'});
+    const auto b = functions.push_back(Append{'b'});
+    const auto c = functions.push_back(Append{'c'});
+    const auto bang = functions.push_back(append_bang);
+    const auto d = functions.push_back([ptr](std::string &str) { str.push_back('d'); });
+
+    REQUIRE(functions.erase(a));
+    REQUIRE_FALSE(functions.erase(a));
+    REQUIRE(functions.erase(bang));
+    REQUIRE(functions.size() == 3);
+
+    std::string str;
+    functions.invoke_all(str);
+
+    REQUIRE(sorted(str) == "bcd");
+
+    REQUIRE(functions.erase(d));
+    REQUIRE(ptr.use_count() == 1);
+
+    REQUIRE(functions.erase(c));
+    REQUIRE(functions.erase(b));
+    REQUIRE(functions.empty());
+
+    str.clear();
+    functions.push_back(Append{'e'});
+    functions.invoke_all(str);
+
+    REQUIRE(str == "e");
+}
+
+TEST_CASE("FunctionVector::clear()", "[fn2::FunctionVector]") {
+    const auto ptr = std::make_shared<int>(0);
+
+    fn2::FunctionVector<void()> functions;
+    functions.push_back([ptr] { ++*ptr; });
+    functions.push_back([ptr] { ++*ptr; });
+    functions.clear();
+    functions.invoke_all();
+
+    REQUIRE(functions.empty());
+    REQUIRE(*ptr == 0);
+    REQUIRE(ptr.use_count() == 1);
+}
+
+TEST_CASE("FunctionVector(FunctionVector&&)", "[fn2::FunctionVector]") {
+    fn2::FunctionVector<void(std::string&)> functions;
+    functions.push_back(Append{'a'});
+
+    fn2::FunctionVector<void(std::string&)> other = std::move(functions);
+    std::string str;
+
+    functions.invoke_all(str);
+    other.invoke_all(str);
+
+    REQUIRE(functions.empty());
+    REQUIRE(str == "a");
+
+    functions.push_back(append_bang);
+    other = std::move(functions);
+    other.invoke_all(str);
+
+    REQUIRE(str == "a!");
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef FN2_TEST_HELPERS_H
+#define FN2_TEST_HELPERS_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// helpers shared by the spec files
+
+struct Append {
+    char ch;
+
+    void operator()(std::string &str) const {
+        str.push_back(ch);
+    }
+};
+
+inline void append_bang(std::string &str) {
+    str.push_back('!');
+}
+
+// copying throws, unless constructed with false
+struct ThrowOnCopy {
+    bool throws = true;
+
+    ThrowOnCopy() = default;
+
+    explicit ThrowOnCopy(bool t) noexcept : throws(t) { }
+
+    ThrowOnCopy(const ThrowOnCopy &other) : throws(other.throws) {
+        if (throws) {
+            throw std::runtime_error("ThrowOnCopy");
+        }
+    }
+
+    ThrowOnCopy(ThrowOnCopy&&) noexcept = default;
+
+    void operator()() const noexcept { }
+
+    void operator()(std::string &str) const {
+        str.push_back('t');
+    }
+};
+
+inline std::string sorted(std::string str) {
+    std::sort(str.begin(), str.end());
+
+    return str;
+}
+
+#endif
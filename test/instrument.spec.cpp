@@ -0,0 +1,167 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// instrumentation changes the layout of vtables, so this file is built
+// into its own executable
+#ifndef FN2_INSTRUMENT
+#define FN2_INSTRUMENT
+#endif
+
+#include <fn2/fn2.h>
+#include <fn2/instrument.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+template <std::size_t Size>
+struct Padded {
+    int operator()(int x) const noexcept {
+        return x + static_cast<int>(data.size());
+    }
+
+    std::array<char, Size> data = {};
+};
+
+using Small = Padded<8>;
+using Large = Padded<256>;
+
+template <typename F>
+fn2::StorageStats stats_of() {
+    const std::vector<fn2::StorageStats> stats = fn2::storage_stats();
+    const auto it = std::find_if(stats.cbegin(), stats.cend(), [](const fn2::StorageStats &s) {
+        return std::string_view(s.name) == typeid(F).name();
+    });
+
+    REQUIRE(it != stats.cend());
+
+    return *it;
+}
+
+} // namespace
+
+TEST_CASE("storage_stats()", "[fn2::storage_stats]") {
+    fn2::reset_storage_stats();
+
+    SECTION("inline construction") {
+        const fn2::Function<int(int)> f = Small();
+        const fn2::StorageStats stats = stats_of<Small>();
+
+        REQUIRE(f(1) == 9);
+        REQUIRE(stats.size == sizeof(Small));
+        REQUIRE(stats.align == alignof(Small));
+        REQUIRE(stats.inline_constructions == 1);
+        REQUIRE(stats.heap_constructions == 0);
+        REQUIRE(stats.bytes_allocated == 0);
+    }
+
+    SECTION("heap construction") {
+        const fn2::Function<int(int)> f = Large();
+        const fn2::StorageStats stats = stats_of<Large>();
+
+        REQUIRE(stats.inline_constructions == 0);
+        REQUIRE(stats.heap_constructions == 1);
+        REQUIRE(stats.bytes_allocated >= sizeof(Large));
+    }
+
+    SECTION("clones and moves") {
+        fn2::Function<int(int)> f = Large();
+        const fn2::Function<int(int)> g = f;
+        const fn2::Function<int(int)> h = std::move(f);
+        fn2::Function<int(int)> i = Small();
+        fn2::Function<int(int)> j = Small();
+
+        swap(i, j);
+
+        const fn2::StorageStats large = stats_of<Large>();
+        const fn2::StorageStats small = stats_of<Small>();
+
+        REQUIRE(large.heap_constructions == 1);
+        REQUIRE(large.clones == 1);
+        REQUIRE(large.moves == 1);
+        REQUIRE(large.bytes_allocated >= 2 * sizeof(Large));
+        REQUIRE(small.inline_constructions == 2);
+        REQUIRE(small.moves == 2);
+    }
+
+    SECTION("shared copies allocate nothing") {
+        const fn2::SharedFunction<int(int) const> f = Large();
+        const std::uint64_t bytes = stats_of<Large>().bytes_allocated;
+        const fn2::SharedFunction<int(int) const> g = f;
+        const fn2::StorageStats stats = stats_of<Large>();
+
+        REQUIRE(stats.clones == 1);
+        REQUIRE(stats.bytes_allocated == bytes);
+    }
+
+    SECTION("most heap constructions first") {
+        const std::vector<fn2::Function<int(int)>> fs = {Large(), Large(), Small()};
+        const std::vector<fn2::StorageStats> stats = fn2::storage_stats();
+
+        REQUIRE(std::is_sorted(stats.cbegin(), stats.cend(), [](const auto &lhs, const auto &rhs) {
+            return lhs.heap_constructions > rhs.heap_constructions;
+        }));
+    }
+
+    SECTION("reset") {
+        const fn2::Function<int(int)> f = Large();
+
+        fn2::reset_storage_stats();
+
+        REQUIRE(stats_of<Large>().heap_constructions == 0);
+    }
+
+    SECTION("report") {
+        const fn2::Function<int(int)> f = Large();
+        std::ostringstream os;
+
+        fn2::report_storage_stats(os);
+
+        REQUIRE(os.str().find(typeid(Large).name()) != std::string::npos);
+    }
+}
+
+TEST_CASE("storage_stats() of reused blocks", "[fn2::storage_stats]") {
+    fn2::reset_storage_stats();
+
+    fn2::Function<int(int)> f = Large();
+    const std::uint64_t bytes = stats_of<Large>().bytes_allocated;
+
+    f = Large();
+
+    const fn2::StorageStats stats = stats_of<Large>();
+
+    REQUIRE(stats.heap_constructions == 2);
+    REQUIRE(stats.bytes_allocated == bytes);
+}
@@ -0,0 +1,359 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/signal.h>
+
+#include <fn2/thread_pool.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+template class fn2::Signal<void(std::string&)>;
+template class fn2::Signal<void(int) noexcept>;
+
+TEST_CASE("Signal::connect(F&&)", "[fn2::Signal]") {
+    fn2::Signal<void(std::string&)> signal;
+    REQUIRE(signal.empty());
+
+    const auto a = signal.connect(Append{'a'});
+    const auto b = signal.connect([](std::string &str) { str.append("bc"); });
+    const auto d = signal.connect([p = std::make_unique<char>('d')](std::string &str) { str.push_back(*p); });
+
+    REQUIRE(signal.size() == 3);
+    REQUIRE(signal.connected(a));
+    REQUIRE(signal.connected(b));
+    REQUIRE(signal.connected(d));
+    REQUIRE_FALSE(signal.connected({}));
+
+    std::string str;
+    signal.emit(str);
+    REQUIRE(str == "abcd");
+
+    SECTION("heap-stored slots") {
+        std::array<char, 256> big{};
+        big[0] = 'e';
+        signal.connect([big](std::string &s) { s.push_back(big[0]); });
+
+        str.clear();
+        signal.emit(str);
+        REQUIRE(sorted(str) == "abcde");
+    }
+
+    SECTION("throwing constructor") {
+        struct Throws {
+            Throws() = default;
+
+            Throws(const Throws&) {
+                throw std::runtime_error("copy");
+            }
+
+            Throws(Throws&&) noexcept = default;
+
+            void operator()(std::string&) const { }
+        };
+
+        const Throws throws;
+        REQUIRE_THROWS_AS(signal.connect(throws), std::runtime_error);
+        REQUIRE(signal.size() == 3);
+
+        str.clear();
+        signal.emit(str);
+        REQUIRE(str == "abcd");
+    }
+}
+
+TEST_CASE("Signal::disconnect(Connection)", "[fn2::Signal]") {
+    fn2::Signal<void(std::string&)> signal;
+    const auto a = signal.connect(Append{'a'});
+    const auto b = signal.connect(Append{'b'});
+    const auto c = signal.connect(Append{'c'});
+
+    REQUIRE(signal.disconnect(a));
+    REQUIRE_FALSE(signal.connected(a));
+    REQUIRE_FALSE(signal.disconnect(a));
+    REQUIRE_FALSE(signal.disconnect({}));
+    REQUIRE(signal.size() == 2);
+
+    std::string str;
+    signal.emit(str);
+    REQUIRE(sorted(str) == "bc");
+
+    // the handle of a is reused, but a must not identify the new slot
+    const auto d = signal.connect(Append{'d'});
+    REQUIRE_FALSE(signal.connected(a));
+    REQUIRE_FALSE(signal.disconnect(a));
+    REQUIRE(signal.connected(d));
+
+    REQUIRE(signal.disconnect(c));
+    REQUIRE(signal.disconnect(b));
+
+    str.clear();
+    signal.emit(str);
+    REQUIRE(str == "d");
+
+    signal.clear();
+    REQUIRE(signal.empty());
+    REQUIRE_FALSE(signal.connected(d));
+
+    str.clear();
+    signal.emit(str);
+    REQUIRE(str.empty());
+}
+
+TEST_CASE("Signal::emit(As...) reentrancy", "[fn2::Signal]") {
+    fn2::Signal<void(std::string&)> signal;
+
+    SECTION("disconnecting during emission") {
+        fn2::Signal<void(std::string&)>::Connection self;
+        fn2::Signal<void(std::string&)>::Connection other;
+        const auto destroyed = std::make_shared<int>(0);
+
+        self = signal.connect([&signal, &self, destroyed](std::string &str) {
+            // still alive after disconnecting itself
+            REQUIRE(signal.disconnect(self));
+            str.append(std::to_string(destroyed.use_count()));
+        });
+        other = signal.connect([&signal, &other](std::string &str) {
+            str.push_back('o');
+            signal.disconnect(other);
+        });
+        signal.connect(Append{'x'});
+
+        std::string str;
+        signal.emit(str);
+        REQUIRE(sorted(str) == "2ox");
+        REQUIRE(signal.size() == 1);
+        REQUIRE(destroyed.use_count() == 1);
+
+        str.clear();
+        signal.emit(str);
+        REQUIRE(str == "x");
+    }
+
+    SECTION("disconnecting a later slot") {
+        fn2::Signal<void(std::string&)>::Connection a;
+        fn2::Signal<void(std::string&)>::Connection b;
+        a = signal.connect([&](std::string &str) {
+            str.push_back('a');
+            signal.disconnect(b);
+        });
+        b = signal.connect([&](std::string &str) {
+            str.push_back('b');
+            signal.disconnect(a);
+        });
+
+        std::string str;
+        signal.emit(str);
+        REQUIRE(str.size() == 1);
+        REQUIRE(signal.size() == 1);
+    }
+
+    SECTION("connecting during emission") {
+        signal.connect([&signal](std::string &str) {
+            str.push_back('a');
+
+            if (signal.size() < 4) {
+                signal.connect(Append{'b'});
+            }
+        });
+
+        std::string str;
+        signal.emit(str);
+        REQUIRE(str == "a");
+        REQUIRE(signal.size() == 2);
+
+        str.clear();
+        signal.emit(str);
+        REQUIRE(sorted(str) == "ab");
+        REQUIRE(signal.size() == 3);
+    }
+
+    SECTION("disconnecting a slot connected during emission") {
+        signal.connect([&signal](std::string &str) {
+            str.push_back('a');
+            const auto b = signal.connect(Append{'b'});
+            const auto c = signal.connect(Append{'c'});
+            REQUIRE(signal.disconnect(b));
+            REQUIRE(signal.connected(c));
+        });
+
+        std::string str;
+        signal.emit(str);
+        REQUIRE(str == "a");
+        REQUIRE(signal.size() == 2);
+
+        signal.clear();
+        signal.connect(Append{'x'});
+
+        str.clear();
+        signal.emit(str);
+        REQUIRE(str == "x");
+    }
+
+    SECTION("emitting during emission") {
+        int depth = 0;
+        signal.connect([&](std::string &str) {
+            str.push_back('a');
+
+            if (depth++ == 0) {
+                signal.emit(str);
+            }
+        });
+        signal.connect(Append{'b'});
+
+        std::string str;
+        signal.emit(str);
+        REQUIRE(sorted(str) == "aabb");
+    }
+
+    SECTION("clearing during emission") {
+        signal.connect([&signal](std::string &str) {
+            str.push_back('a');
+            signal.clear();
+        });
+        signal.connect(Append{'b'});
+
+        std::string str;
+        signal.emit(str);
+        REQUIRE(str.size() == 1);
+        REQUIRE(signal.empty());
+
+        str.clear();
+        signal.emit(str);
+        REQUIRE(str.empty());
+    }
+
+    SECTION("throwing slots") {
+        fn2::Signal<void(std::string&)>::Connection self;
+        self = signal.connect([&](std::string&) {
+            signal.disconnect(self);
+
+            throw std::runtime_error("slot");
+        });
+
+        std::string str;
+        REQUIRE_THROWS_AS(signal.emit(str), std::runtime_error);
+        REQUIRE(signal.empty());
+
+        signal.connect(Append{'a'});
+        signal.emit(str);
+        REQUIRE(str == "a");
+    }
+}
+
+TEST_CASE("Signal move", "[fn2::Signal]") {
+    fn2::Signal<void(std::string&)> signal;
+    const auto a = signal.connect(Append{'a'});
+
+    fn2::Signal<void(std::string&)> other(std::move(signal));
+    REQUIRE(signal.empty());
+    REQUIRE(other.size() == 1);
+    REQUIRE(other.connected(a));
+
+    signal = std::move(other);
+    REQUIRE(other.empty());
+    REQUIRE(signal.disconnect(a));
+    REQUIRE(signal.empty());
+
+    SECTION("connections made before a move") {
+        fn2::Signal<void(std::string&)> target;
+        fn2::Signal<void(std::string&)> source;
+        const auto t = target.connect(Append{'t'});
+        const auto s = source.connect(Append{'s'});
+
+        // t and s have the same handle, so only the Signal tells them
+        // apart
+        target = std::move(source);
+        REQUIRE_FALSE(target.connected(t));
+        REQUIRE_FALSE(target.disconnect(t));
+        REQUIRE(target.connected(s));
+        REQUIRE(target.size() == 1);
+
+        std::string str;
+        target.emit(str);
+        REQUIRE(str == "s");
+
+        // the moved-from Signal reuses its handles, but s must not
+        // identify its new slot
+        const auto u = source.connect(Append{'u'});
+        REQUIRE_FALSE(source.connected(s));
+        REQUIRE_FALSE(source.disconnect(s));
+        REQUIRE(source.connected(u));
+        REQUIRE_FALSE(target.connected(u));
+
+        fn2::Signal<void(std::string&)> constructed(std::move(source));
+        const auto v = source.connect(Append{'v'});
+        REQUIRE(constructed.connected(u));
+        REQUIRE_FALSE(source.connected(u));
+        REQUIRE_FALSE(constructed.connected(v));
+        REQUIRE(source.connected(v));
+    }
+}
+
+TEST_CASE("Signal::emit_parallel(P&, std::size_t, As...)", "[fn2::Signal]") {
+    constexpr std::size_t NUM_SLOTS = 1000;
+
+    fn2::ThreadPool pool(4);
+    fn2::Signal<void(int) noexcept> signal;
+    std::vector<std::atomic<int>> sums(NUM_SLOTS);
+
+    for (std::size_t i = 0; i < NUM_SLOTS; ++i) {
+        signal.connect([&sums, i](int x) noexcept { sums[i].fetch_add(x, std::memory_order_relaxed); });
+    }
+
+    for (const std::size_t grain : {std::size_t(0), std::size_t(1), std::size_t(64), NUM_SLOTS, 2 * NUM_SLOTS}) {
+        signal.emit_parallel(pool, grain, 1);
+    }
+
+    signal.emit(1);
+
+    REQUIRE(std::all_of(sums.begin(), sums.end(), [](const std::atomic<int> &sum) { return sum.load() == 6; }));
+
+    SECTION("throwing slots") {
+        fn2::Signal<void(int)> throwing;
+        std::atomic<int> count{0};
+
+        for (std::size_t i = 0; i < 100; ++i) {
+            throwing.connect([&count, i](int) {
+                count.fetch_add(1, std::memory_order_relaxed);
+
+                if (i % 10 == 0) {
+                    throw std::runtime_error("slot");
+                }
+            });
+        }
+
+        REQUIRE_THROWS_AS(throwing.emit_parallel(pool, 10, 0), std::runtime_error);
+        REQUIRE(count.load() == 10);
+    }
+}
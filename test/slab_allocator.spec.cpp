@@ -0,0 +1,196 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/fn2.h>
+#include <fn2/slab_allocator.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+template class fn2::SlabAllocator<int>;
+
+static_assert(fn2::detail::size_class(1) == 0);
+static_assert(fn2::detail::size_class(16) == 0);
+static_assert(fn2::detail::size_class(17) == 1);
+static_assert(fn2::detail::size_class(128) == 7);
+static_assert(fn2::detail::size_class(129) == 8);
+static_assert(fn2::detail::size_class(192) == 8);
+static_assert(fn2::detail::size_class(193) == 9);
+
+static_assert(std::is_same_v<fn2::detail::DefaultAllocator, fn2::SlabAllocator<std::byte>>);
+
+namespace {
+
+template <std::size_t Size, std::size_t Align = alignof(std::max_align_t)>
+struct alignas(Align) Bytes {
+    std::array<unsigned char, Size> data;
+};
+
+template <typename T>
+bool is_aligned(const T *ptr) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignof(T) == 0;
+}
+
+} // namespace
+
+TEST_CASE("SlabAllocator::allocate(std::size_t)", "[fn2::SlabAllocator]") {
+    SECTION("freed blocks are reused") {
+        fn2::SlabAllocator<Bytes<100>> alloc;
+        Bytes<100> *const ptr = alloc.allocate(1);
+
+        alloc.deallocate(ptr, 1);
+
+        REQUIRE(alloc.allocate(1) == ptr);
+
+        alloc.deallocate(ptr, 1);
+    }
+
+    SECTION("blocks are distinct and aligned") {
+        fn2::SlabAllocator<Bytes<48>> alloc;
+        std::vector<Bytes<48>*> ptrs;
+
+        for (unsigned char i = 0; i < 200; ++i) {
+            ptrs.push_back(alloc.allocate(1));
+            std::memset(ptrs.back(), i, sizeof(Bytes<48>));
+        }
+
+        for (std::size_t i = 0; i < ptrs.size(); ++i) {
+            REQUIRE(is_aligned(ptrs[i]));
+            REQUIRE(ptrs[i]->data[0] == i);
+            REQUIRE(ptrs[i]->data[47] == i);
+        }
+
+        for (Bytes<48> *ptr : ptrs) {
+            alloc.deallocate(ptr, 1);
+        }
+    }
+
+    SECTION("large and overaligned") {
+        fn2::SlabAllocator<Bytes<1024>> large;
+        fn2::SlabAllocator<Bytes<64, 64>> overaligned;
+        Bytes<1024> *const ptr = large.allocate(1);
+        Bytes<64, 64> *const array = overaligned.allocate(3);
+
+        REQUIRE(is_aligned(ptr));
+        REQUIRE(is_aligned(array));
+
+        large.deallocate(ptr, 1);
+        overaligned.deallocate(array, 3);
+    }
+
+    SECTION("standard containers") {
+        std::vector<int, fn2::SlabAllocator<int>> v;
+        std::map<int, int, std::less<int>, fn2::SlabAllocator<std::pair<const int, int>>> m;
+
+        for (int i = 0; i < 1000; ++i) {
+            v.push_back(i);
+            m.emplace(i, i * 2);
+        }
+
+        REQUIRE(v[999] == 999);
+        REQUIRE(m.at(500) == 1000);
+    }
+}
+
+TEST_CASE("SlabAllocator across threads", "[fn2::SlabAllocator]") {
+    SECTION("blocks may be freed by another thread") {
+        fn2::SlabAllocator<Bytes<256>> alloc;
+        std::vector<Bytes<256>*> ptrs;
+
+        std::thread([&alloc, &ptrs] {
+            for (int i = 0; i < 1000; ++i) {
+                ptrs.push_back(alloc.allocate(1));
+            }
+        }).join();
+
+        std::thread([&alloc, &ptrs] {
+            for (Bytes<256> *ptr : ptrs) {
+                alloc.deallocate(ptr, 1);
+            }
+        }).join();
+    }
+
+    SECTION("cached blocks are returned when a thread exits") {
+        fn2::SlabAllocator<Bytes<320>> alloc;
+        Bytes<320> *ptr = nullptr;
+
+        std::thread([&alloc, &ptr] {
+            ptr = alloc.allocate(1);
+            alloc.deallocate(ptr, 1);
+        }).join();
+
+        // a new thread has no cached blocks, so it takes the most
+        // recently returned batch from the pool
+        Bytes<320> *reused = nullptr;
+
+        std::thread([&alloc, &reused] {
+            reused = alloc.allocate(1);
+        }).join();
+
+        REQUIRE(reused == ptr);
+
+        alloc.deallocate(reused, 1);
+    }
+
+    SECTION("Functions churn on several threads") {
+        std::vector<std::thread> threads;
+        std::vector<int> sums(4);
+
+        for (int &sum : sums) {
+            threads.emplace_back([&sum] {
+                std::vector<fn2::Function<int()>> functions(64);
+
+                for (int i = 0; i < 10000; ++i) {
+                    std::array<int, 32> data = {};
+                    data[31] = 1;
+
+                    auto &f = functions[static_cast<std::size_t>(i) % functions.size()];
+
+                    if (f) {
+                        sum += f();
+                    }
+
+                    f = [data] { return data[31]; };
+                }
+            });
+        }
+
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        for (int sum : sums) {
+            REQUIRE(sum == 10000 - 64);
+        }
+    }
+}
@@ -0,0 +1,231 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/task_queue.h>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+template class fn2::BasicTaskQueue<>;
+
+TEST_CASE("TaskQueue(std::size_t)", "[fn2::TaskQueue]") {
+    REQUIRE(fn2::TaskQueue(1).capacity() == 1);
+    REQUIRE(fn2::TaskQueue(5).capacity() == 8);
+    REQUIRE(fn2::TaskQueue(64).capacity() == 64);
+}
+
+TEST_CASE("TaskQueue::try_push(F&&)", "[fn2::TaskQueue]") {
+    SECTION("first in, first out") {
+        fn2::TaskQueue queue(4);
+        std::vector<int> order;
+
+        REQUIRE(queue.empty());
+        REQUIRE_FALSE(queue.try_invoke());
+
+        REQUIRE(queue.try_push([&order] { order.push_back(0); }));
+        REQUIRE_FALSE(queue.empty());
+        REQUIRE(queue.try_emplace<fn2::UniqueFunction<void()>>([&order] { order.push_back(1); }));
+        REQUIRE(queue.try_push(fn2::UniqueFunction<void()>([&order] { order.push_back(2); })));
+
+        REQUIRE(queue.invoke_all() == 3);
+        REQUIRE(order == std::vector<int>{0, 1, 2});
+        REQUIRE_FALSE(queue.try_invoke());
+    }
+
+    SECTION("full") {
+        fn2::TaskQueue queue(2);
+        int count = 0;
+
+        REQUIRE(queue.try_push([&count] { ++count; }));
+        REQUIRE(queue.try_push([&count] { ++count; }));
+        REQUIRE_FALSE(queue.try_push([&count] { ++count; }));
+
+        REQUIRE(queue.try_invoke());
+        REQUIRE(queue.try_push([&count] { ++count; }));
+
+        REQUIRE(queue.invoke_all() == 2);
+        REQUIRE(count == 3);
+    }
+
+    SECTION("move-only and heap-stored tasks") {
+        fn2::TaskQueue queue(4);
+        int result = 0;
+
+        std::array<int, 32> values = {};
+        values[31] = 5;
+
+        REQUIRE(queue.try_push([ptr = std::make_unique<int>(3), &result] { result += *ptr; }));
+        REQUIRE(queue.try_push([values, &result] { result += values[31]; }));
+
+        REQUIRE(queue.invoke_all() == 2);
+        REQUIRE(result == 8);
+    }
+
+    SECTION("constructor throws") {
+        fn2::TaskQueue queue(2);
+        const ThrowOnCopy throws;
+        int count = 0;
+
+        REQUIRE_THROWS_AS(queue.try_push(throws), std::runtime_error);
+        REQUIRE(queue.try_push([&count] { ++count; }));
+
+        // the slot of the task that threw is skipped, not counted
+        REQUIRE(queue.invoke_all() == 1);
+        REQUIRE(count == 1);
+
+        REQUIRE_THROWS_AS(queue.try_push(throws), std::runtime_error);
+        REQUIRE_FALSE(queue.try_invoke());
+        REQUIRE(queue.empty());
+    }
+
+    SECTION("null pointers and empty tasks") {
+        fn2::TaskQueue queue(1);
+        void (*const null)() = nullptr;
+        int count = 0;
+
+        // rejected without using the only slot
+        REQUIRE_FALSE(queue.try_push(null));
+        REQUIRE_FALSE(queue.try_push(fn2::TaskQueue::Task()));
+        REQUIRE_FALSE(queue.try_push(fn2::Function<void()>()));
+        REQUIRE_FALSE(queue.try_push(fn2::UniqueFunction<void()>()));
+        REQUIRE_FALSE(queue.try_push(std::function<void()>()));
+        REQUIRE_FALSE(queue.try_emplace<void(*)()>(nullptr));
+        REQUIRE_FALSE(queue.try_emplace<fn2::Function<void()>>());
+        REQUIRE_FALSE(queue.try_emplace<std::function<void()>>());
+        REQUIRE(queue.empty());
+
+        REQUIRE(queue.try_push([&count] { ++count; }));
+        REQUIRE(queue.try_invoke());
+        REQUIRE(count == 1);
+        REQUIRE_FALSE(queue.try_invoke());
+        REQUIRE(queue.empty());
+
+        // non-empty pointers and wrappers are still emplaced
+        REQUIRE(queue.try_emplace<std::function<void()>>([&count] { ++count; }));
+        REQUIRE(queue.try_invoke());
+        REQUIRE(count == 2);
+    }
+
+    SECTION("try_pop") {
+        fn2::TaskQueue queue(4);
+        const ThrowOnCopy throws;
+        std::vector<int> order;
+
+        REQUIRE_FALSE(queue.try_pop());
+
+        REQUIRE(queue.try_push([&order] { order.push_back(0); }));
+        REQUIRE_THROWS_AS(queue.try_push(throws), std::runtime_error);
+        REQUIRE(queue.try_push([&order] { order.push_back(1); }));
+
+        const fn2::TaskQueue::Task first = queue.try_pop();
+        REQUIRE(first);
+
+        // the slot of the task that threw is skipped
+        const fn2::TaskQueue::Task second = queue.try_pop();
+        REQUIRE(second);
+        REQUIRE(queue.empty());
+        REQUIRE_FALSE(queue.try_pop());
+
+        second();
+        first();
+        REQUIRE(order == std::vector<int>{1, 0});
+    }
+
+    SECTION("task throws") {
+        fn2::TaskQueue queue(2);
+        const auto ptr = std::make_shared<int>(0);
+
+        REQUIRE(queue.try_push([ptr] { throw std::runtime_error("task"); }));
+        REQUIRE(queue.try_push([ptr] { ++*ptr; }));
+
+        REQUIRE_THROWS_AS(queue.try_invoke(), std::runtime_error);
+        REQUIRE(ptr.use_count() == 2);
+
+        REQUIRE(queue.try_invoke());
+        REQUIRE(*ptr == 1);
+        REQUIRE(ptr.use_count() == 1);
+    }
+
+    SECTION("destroys tasks that were not invoked") {
+        const auto ptr = std::make_shared<int>(0);
+
+        {
+            fn2::TaskQueue queue(4);
+
+            REQUIRE(queue.try_push([ptr] { ++*ptr; }));
+            REQUIRE(queue.try_push([ptr] { ++*ptr; }));
+            REQUIRE(ptr.use_count() == 3);
+        }
+
+        REQUIRE(*ptr == 0);
+        REQUIRE(ptr.use_count() == 1);
+    }
+}
+
+TEST_CASE("TaskQueue with concurrent producers", "[fn2::TaskQueue]") {
+    constexpr std::size_t NUM_PRODUCERS = 4;
+    constexpr std::size_t NUM_TASKS = 10000;
+
+    fn2::TaskQueue queue(64);
+    std::vector<std::size_t> counts(NUM_PRODUCERS);
+    std::vector<std::thread> producers;
+
+    for (std::size_t i = 0; i < NUM_PRODUCERS; ++i) {
+        producers.emplace_back([&queue, &counts, i] {
+            for (std::size_t j = 0; j < NUM_TASKS; ++j) {
+                // tasks from one producer are invoked in the order they
+                // were pushed
+                while (!queue.try_push([&counts, i, j] { counts[i] += (counts[i] == j); })) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::size_t invoked = 0;
+
+    while (invoked < NUM_PRODUCERS * NUM_TASKS) {
+        const std::size_t count = queue.invoke_all();
+
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+
+        invoked += count;
+    }
+
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+
+    REQUIRE(counts == std::vector<std::size_t>(NUM_PRODUCERS, NUM_TASKS));
+}
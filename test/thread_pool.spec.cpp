@@ -0,0 +1,205 @@
+// Copyright (c) 2019 Gregory Meyer
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice (including
+// the next paragraph) shall be included in all copies or substantial
+// portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <fn2/thread_pool.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+// submits 2^depth leaf tasks by recursive halving
+void fan_out(fn2::ThreadPool &pool, std::atomic<std::size_t> &leaves, int depth) {
+    if (depth == 0) {
+        leaves.fetch_add(1, std::memory_order_relaxed);
+
+        return;
+    }
+
+    pool.submit([&pool, &leaves, depth] { fan_out(pool, leaves, depth - 1); });
+    pool.submit([&pool, &leaves, depth] { fan_out(pool, leaves, depth - 1); });
+}
+
+} // namespace
+
+TEST_CASE("detail::StealingDeque", "[fn2::ThreadPool]") {
+    fn2::detail::StealingDeque<fn2::UniqueFunction<int()>> deque(4);
+
+    REQUIRE(deque.empty());
+    REQUIRE_FALSE(deque.pop());
+    REQUIRE_FALSE(deque.steal());
+
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(deque.push([i] { return i; }));
+    }
+
+    REQUIRE_FALSE(deque.push([] { return 4; }));
+    REQUIRE_FALSE(deque.empty());
+
+    // the owner pops the newest, thieves steal the oldest
+    REQUIRE(deque.pop()() == 3);
+    REQUIRE(deque.steal()() == 0);
+    REQUIRE(deque.push([ptr = std::make_unique<int>(5)] { return *ptr; }));
+    REQUIRE(deque.pop()() == 5);
+    REQUIRE(deque.steal()() == 1);
+    REQUIRE(deque.pop()() == 2);
+    REQUIRE(deque.empty());
+}
+
+TEST_CASE("ThreadPool::submit(F&&)", "[fn2::ThreadPool]") {
+    SECTION("from outside the pool") {
+        std::atomic<int> count{0};
+
+        {
+            fn2::ThreadPool pool(4);
+
+            REQUIRE(pool.size() == 4);
+
+            for (int i = 0; i < 10000; ++i) {
+                pool.submit([&count] { count.fetch_add(1, std::memory_order_relaxed); });
+            }
+        }
+
+        REQUIRE(count.load() == 10000);
+    }
+
+    SECTION("from tasks") {
+        std::atomic<std::size_t> leaves{0};
+
+        {
+            fn2::ThreadPool pool(4);
+            pool.submit([&pool, &leaves] { fan_out(pool, leaves, 12); });
+        }
+
+        REQUIRE(leaves.load() == 1 << 12);
+    }
+
+    SECTION("more tasks than fit in a deque") {
+        std::atomic<int> count{0};
+
+        {
+            fn2::ThreadPool pool(2);
+            pool.submit([&pool, &count] {
+                for (int i = 0; i < 5000; ++i) {
+                    pool.submit([&count] { count.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+
+        REQUIRE(count.load() == 5000);
+    }
+
+    SECTION("move-only and heap-stored tasks") {
+        std::atomic<int> sum{0};
+        std::array<int, 32> values = {};
+        values[31] = 2;
+
+        {
+            fn2::ThreadPool pool(2);
+            pool.submit([ptr = std::make_unique<int>(3), &sum] { sum += *ptr; });
+            pool.submit([values, &sum] { sum += values[31]; });
+            pool.submit(fn2::UniqueFunction<void()>([&sum] { sum += 1; }));
+        }
+
+        REQUIRE(sum.load() == 6);
+    }
+
+    SECTION("null pointers and empty tasks") {
+        fn2::ThreadPool pool(1);
+        void (*const null)() = nullptr;
+
+        // returns rather than waiting for a slot that is never taken
+        pool.submit(null);
+        pool.submit(fn2::ThreadPool::Task());
+        pool.submit(fn2::Function<void()>());
+        pool.submit(fn2::UniqueFunction<void()>());
+        pool.submit(std::function<void()>());
+
+        REQUIRE_FALSE(pool.try_run_one());
+    }
+
+    SECTION("empty functions submitted by a worker") {
+        std::atomic<bool> ran{false};
+
+        {
+            fn2::ThreadPool pool(1);
+            pool.submit([&pool, &ran] {
+                pool.submit(fn2::Function<void()>());
+                pool.submit(std::function<void()>());
+                ran.store(true);
+            });
+        }
+
+        REQUIRE(ran.load());
+    }
+}
+
+TEST_CASE("ThreadPool with a blocked worker", "[fn2::ThreadPool]") {
+    // tasks submitted from outside go to each worker's TaskQueue in
+    // turn, so task 0 and task 2 wait for the same worker. While that
+    // worker is blocked in task 0, the other must take task 2
+    std::atomic<bool> done{false};
+    std::atomic<bool> waited{false};
+
+    {
+        fn2::ThreadPool pool(2);
+
+        pool.submit([&done, &waited] {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+            while (!done.load() && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+
+            waited.store(done.load());
+        });
+        pool.submit([] { });
+        pool.submit([&done] { done.store(true); });
+    }
+
+    REQUIRE(waited.load());
+}
+
+TEST_CASE("ThreadPool::try_run_one()", "[fn2::ThreadPool]") {
+    fn2::ThreadPool pool(2);
+    std::atomic<std::size_t> leaves{0};
+
+    pool.submit([&pool, &leaves] { fan_out(pool, leaves, 10); });
+
+    // help until all leaves have run
+    while (leaves.load() < 1 << 10) {
+        if (!pool.try_run_one()) {
+            std::this_thread::yield();
+        }
+    }
+
+    REQUIRE(leaves.load() == 1 << 10);
+}